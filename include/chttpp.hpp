@@ -4,9 +4,30 @@
 #include <chrono>
 #include <functional>
 #include <utility>
+#include <cstring>
+#include <array>
+#include <charconv>
+#include <optional>
+#include <variant>
+#include <tuple>
+#include <memory>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <thread>
+
+#ifndef _MSC_VER
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#endif
 
 #include "underlying/common.hpp"
 #include "null_terminated_string_view.hpp"
+#include "digest.hpp"
 //#include "mime_types.hpp"
 
 namespace chttpp::underlying::agent_impl {
@@ -101,6 +122,42 @@ namespace chttpp {
       using element_type = T;
     };
 
+    /**
+    * @brief バイト列の断片（セグメント）の範囲であることを表す
+    */
+    template<typename R>
+    concept byte_segment_range =
+      std::ranges::forward_range<R> and
+      std::convertible_to<std::ranges::range_reference_t<R>, std::span<const char>>;
+
+    struct as_byte_segments_impl {
+
+      /**
+      * @brief 1. as_byte_segments()メンバ関数を呼び出し、その結果を取得する
+      * @details 戻り値のセグメントの範囲は右辺値でも良いが、各セグメントの指す領域は元のオブジェクトが保持している必要がある
+      */
+      template<typename T>
+        requires requires(T&& t) {
+          { std::forward<T>(t).as_byte_segments() } -> byte_segment_range;
+        }
+      [[nodiscard]]
+      decltype(auto) operator()(T&& t) const noexcept(noexcept(std::forward<T>(t).as_byte_segments())) {
+        return std::forward<T>(t).as_byte_segments();
+      }
+
+      /**
+      * @brief 2. as_byte_segments()非メンバ関数を呼び出し、その結果を取得する
+      */
+      template<typename T>
+        requires requires(T&& t) {
+          { as_byte_segments(std::forward<T>(t)) } -> byte_segment_range;
+        }
+      [[nodiscard]]
+      decltype(auto) operator()(T&& t) const noexcept(noexcept(as_byte_segments(std::forward<T>(t)))) {
+        return as_byte_segments(std::forward<T>(t));
+      }
+    };
+
     struct as_byte_seq_impl {
 
       /**
@@ -120,13 +177,16 @@ namespace chttpp {
       /**
       * @brief 1. contiguous_rangeな範囲をバイト列へ変換する
       * @details 利用側はこの結果を直接span<const char>を受け取る関数へ渡すことを想定するので右辺値が来ても良い
+      * @details 要素型はトリビアルコピー可能かつview以外である必要がある（std::stringやstd::string_viewの範囲などは、チャンクの範囲として扱われる）
       */
       template<std::ranges::contiguous_range R>
         requires (not string_like<R>) and
                  requires(R& t) {
                    std::ranges::data(t);
                  } and
-                 std::ranges::sized_range<R>
+                 std::ranges::sized_range<R> and
+                 std::is_trivially_copyable_v<std::ranges::range_value_t<R>> and
+                 (not std::ranges::view<std::ranges::range_value_t<R>>)
       [[nodiscard]]
       auto operator()(R&& t) const noexcept -> std::span<const char> {
         return {reinterpret_cast<const char*>(std::ranges::data(t)), sizeof(std::ranges::range_value_t<R>) * std::ranges::size(t)};
@@ -164,7 +224,8 @@ namespace chttpp {
       * @brief 4. C-likeな構造体のオブジェクトをそのままシリアライズする
       */
       template<substantial T>
-        requires (not is_specialization_of_span_v<T>) and (not string_like<const T&>)
+        requires (not is_specialization_of_span_v<T>) and (not string_like<const T&>) and
+                 (not std::invocable<as_byte_segments_impl, const T&>)
       [[nodiscard]]
       auto operator()(const T& t) const noexcept -> std::span<const char> {
         return {reinterpret_cast<const char*>(std::addressof(t)), sizeof(t)};
@@ -263,6 +324,13 @@ namespace chttpp {
     * @return なし
     */
     inline constexpr detail::load_byte_seq_impl load_byte_seq{};
+
+    /**
+    * @brief オブジェクトを、連結せずにバイト列の断片の列へ変換する
+    * @details as_byte_segments(E);のように呼び出し、Eの示すオブジェクトをstd::span<const char>へ変換可能な要素の範囲へ変換する
+    * @return std::span<const char>へ変換可能な要素を持つforward_range
+    */
+    inline constexpr detail::as_byte_segments_impl as_byte_segments{};
   }
 
   inline namespace concepts {
@@ -282,198 +350,2604 @@ namespace chttpp {
     concept byte_deserializable = requires(T& t, std::span<const char> bytes) {
       cpo::load_byte_seq(t, bytes);
     };
+
+    /**
+    * @brief バイト列として扱うことのできる要素（チャンク）を順に生成する範囲
+    * @details std::generatorなどのinput_rangeを含む
+    */
+    template<typename R>
+    concept byte_chunk_range =
+      std::ranges::input_range<R> and
+      byte_serializable<std::ranges::range_reference_t<R>> and
+      (not byte_serializable<R>);
+
+    /**
+    * @brief 渡されたバッファにリクエストボディを書き込み、書き込んだバイト数（終端では0）を返す関数
+    */
+    template<typename F>
+    concept body_read_function =
+      std::invocable<F&, std::span<char>> and
+      std::convertible_to<std::invoke_result_t<F&, std::span<char>>, std::size_t>;
+
+    /**
+    * @brief 複数のバイト列の断片として扱うことのできる型
+    */
+    template<typename T>
+    concept byte_segmentable = requires(T&& t) {
+      cpo::as_byte_segments(t);
+    };
+
+    /**
+    * @brief リクエストボディとして、逐次読み出して送信することのできる型
+    */
+    template<typename T>
+    concept body_source =
+      std::same_as<std::remove_cvref_t<T>, detail::body_reader> or
+      byte_chunk_range<T> or
+      body_read_function<T> or
+      byte_segmentable<T> or
+      requires(T& t) {
+        { t.as_body_reader() } -> std::same_as<detail::body_reader>;
+      };
   }
-}
 
-namespace chttpp::inline traits {
+  namespace detail {
+
+    /**
+     * @brief byte_chunk_rangeの各要素を順に読み出す
+     * @details 要素が一時オブジェクトの場合、読み出し終わるまで保持しておく
+     */
+    template<std::ranges::view V>
+    class chunk_range_reader {
+      using reference = std::ranges::range_reference_t<V>;
+      using cache_t = std::conditional_t<std::is_reference_v<reference>, std::monostate, std::optional<reference>>;
+
+      V m_range;
+      std::optional<std::ranges::iterator_t<V>> m_it;
+      [[no_unique_address]]
+      cache_t m_cache{};
+      std::span<const char> m_rest{};
+      bool m_done = false;
+
+      bool next_chunk() {
+        if (m_it) {
+          ++*m_it;
+        } else {
+          m_it.emplace(std::ranges::begin(m_range));
+        }
+
+        if (*m_it == std::ranges::end(m_range)) {
+          m_done = true;
+          return false;
+        }
+
+        if constexpr (std::is_reference_v<reference>) {
+          auto&& chunk = **m_it;
+          m_rest = cpo::as_byte_seq(chunk);
+        } else {
+          m_rest = cpo::as_byte_seq(m_cache.emplace(**m_it));
+        }
+
+        return true;
+      }
+
+    public:
+
+      explicit chunk_range_reader(V range)
+        : m_range(std::move(range))
+      {}
+
+      auto operator()(std::span<char> buffer) -> std::size_t {
+        std::size_t written = 0;
+
+        while (written < buffer.size()) {
+          if (m_rest.empty()) {
+            if (m_done or not next_chunk()) break;
+            continue;
+          }
+
+          const std::size_t len = std::min(buffer.size() - written, m_rest.size());
+          std::memcpy(buffer.data() + written, m_rest.data(), len);
+
+          written += len;
+          m_rest = m_rest.subspan(len);
+        }
+
+        return written;
+      }
+
+      /**
+       * @brief 先頭からoffsetの位置から読み出し直す
+       * @details 範囲を先頭から辿り直すため、forward_rangeの場合のみ可能
+       */
+      bool seek(std::size_t offset) requires std::ranges::forward_range<V> {
+        m_it.reset();
+        m_rest = {};
+        m_done = false;
+
+        while (offset != 0) {
+          if (m_rest.empty()) {
+            if (not next_chunk()) return false;
+            continue;
+          }
+
+          const std::size_t len = std::min(offset, m_rest.size());
+          m_rest = m_rest.subspan(len);
+          offset -= len;
+        }
+
+        return true;
+      }
+    };
+
+    /**
+     * @brief 読み出しとシークを行うオブジェクトを共有して、読み直し可能なbody_readerを作成する
+     */
+    template<typename Reader>
+    auto make_seekable_body_reader(Reader reader, std::size_t length) -> body_reader {
+      auto shared = std::make_shared<Reader>(std::move(reader));
+
+      return body_reader{ [shared](std::span<char> buffer) -> std::size_t {
+        return (*shared)(buffer);
+      }, length }.with_seek([shared](std::size_t offset) -> bool {
+        return shared->seek(offset);
+      });
+    }
+
+    template<body_source Source>
+    auto make_body_reader(Source&& source, std::size_t length = body_reader::unknown_length) -> body_reader {
+      if constexpr (std::same_as<std::remove_cvref_t<Source>, body_reader>) {
+        return std::move(source);
+      } else if constexpr (requires { { source.as_body_reader() } -> std::same_as<body_reader>; }) {
+        // 自身の内容を読み出すbody_readerを提供する型（sourceはリクエスト完了まで生存している）
+        return source.as_body_reader();
+      } else if constexpr (body_read_function<Source>) {
+        return body_reader{ [fun = std::forward<Source>(source)](std::span<char> buffer) mutable -> std::size_t {
+          return std::invoke(fun, buffer);
+        }, length };
+      } else if constexpr (byte_segmentable<Source>) {
+        // セグメントを連結せずに、順番に読み出す
+        auto segments = std::views::all(cpo::as_byte_segments(source));
+
+        if (length == body_reader::unknown_length) {
+          length = 0;
+          for (std::span<const char> seg : segments) {
+            length += seg.size();
+          }
+        }
+
+        return make_seekable_body_reader(chunk_range_reader{std::move(segments)}, length);
+      } else {
+        auto chunks = std::views::all(std::forward<Source>(source));
+
+        if constexpr (std::ranges::forward_range<decltype(chunks)>) {
+          // 先頭から辿り直せる範囲は、再送信時に読み直せる
+          return make_seekable_body_reader(chunk_range_reader{std::move(chunks)}, length);
+        } else {
+          return body_reader{ chunk_range_reader{std::move(chunks)}, length };
+        }
+      }
+    }
+  }
 
   /**
-   * @brief content-typeヘッダの値を自動取得する
-   * @tparam T リクエストボディに指定する型
-   * @details リクエストボディの型から取得する、カスタマイズのためには部分特殊化するか、静的メンバ変数ContentTypeを定義する
+   * @brief 複数のオブジェクトのバイト列を、連結せずにそのまま並べたもの
+   * @details 各要素の指す領域は、元のオブジェクトが保持している
    */
-  template<typename T>
-  inline constexpr std::string_view query_content_type = []{ static_assert([]{return false;}(), "Primary template is ill-formed"); }();
+  template<std::size_t N>
+  struct byte_segments_t {
+    std::array<std::span<const char>, N> segments;
+
+    auto as_byte_segments() const noexcept -> std::span<const std::span<const char>, N> {
+      return segments;
+    }
+  };
 
   /**
-   * @brief デフォルト
+   * @brief 複数のオブジェクトを、連結せずに1つのリクエストボディとして送信する
+   * @details byte_segments(header, payload, trailer)のように、各オブジェクトをas_byte_seqで変換したものを順に送信する
    */
-  template<byte_serializable T>
-  inline constexpr std::string_view query_content_type<T> = "application/octet_stream";
+  template<byte_serializable... Ts>
+  auto byte_segments(Ts&&... objs) -> byte_segments_t<sizeof...(Ts)> {
+    return { { std::span<const char>(cpo::as_byte_seq(objs))... } };
+  }
 
   /**
-   * @brief 文字列
+   * @brief チャンクの範囲や読み出し関数から、逐次送信されるリクエストボディを作成する
+   * @param length ボディの長さ、指定しない場合はチャンク形式で送信される
    */
-  template<byte_serializable T>
-    requires detail::string_like<T>
-  inline constexpr std::string_view query_content_type<T> = "text/plain";
+  template<body_source Source>
+  auto stream_body(Source&& source, std::size_t length = detail::body_reader::unknown_length) -> detail::body_reader {
+    return detail::make_body_reader(std::forward<Source>(source), length);
+  }
+
+  namespace detail {
+
+    /**
+     * @brief multipartのパート毎の追加の指定
+     */
+    struct form_part_options {
+      // Content-Dispositionのfilenameパラメータ
+      std::string_view filename = "";
+      // パートのContent-Type
+      std::string_view content_type = "";
+    };
+  }
 
   /**
-   * @brief カスタマイズポイント2、静的メンバ変数ContentTypeから取得
+   * @brief multipart/form-dataのリクエストボディ
+   * @details 送信時にパート毎に逐次読み出され、ボディ全体を連結したバッファは作成されない（libcurl実装のみ）
+   * @details メモリ上のデータは参照のみを保持し、ファイルは送信中にディスクから読み出される
+   * @details 読み出し関数などのストリームによるパートは1度しか送信できない
    */
-  template<byte_serializable T>
-    requires requires {
-      { T::ContentType } -> std::convertible_to<std::string_view>;
-    }
-  inline constexpr std::string_view query_content_type<T> = T::ContentType;
-}
+  class multipart {
+  public:
 
-namespace chttpp::detail {
+    using part_options = detail::form_part_options;
 
-  template<typename MethodTag>
-  struct terse_req_impl {
+    struct part {
+      string_t name;
+      string_t filename;
+      string_t content_type;
+      std::variant<std::span<const char>, std::filesystem::path, detail::body_reader> source;
+    };
 
-    using tag_t = MethodTag;
+  private:
 
-    auto operator()(nt_string_view URL, request_config_for_get cfg = {}) const noexcept -> http_result {
-      return chttpp::underlying::terse::request_impl(URL, std::move(cfg), std::span<const char>{}, MethodTag{});
+    vector_t<part> m_parts{};
+
+    auto add_part(std::string_view name, part_options opt, auto&& source) -> multipart& {
+      m_parts.push_back(part{ string_t{name}, string_t{opt.filename}, string_t{opt.content_type}, std::forward<decltype(source)>(source) });
+      return *this;
     }
 
-    auto operator()(nt_wstring_view URL, request_config_for_get cfg = {}) const noexcept -> http_result {
-      return chttpp::underlying::terse::request_impl(URL, std::move(cfg), std::span<const char>{}, MethodTag{});
+  public:
+
+    /**
+     * @brief メモリ上のデータをパートとして追加する
+     * @details dataの領域はコピーされないため、送信完了まで生存している必要がある
+     */
+    template<byte_serializable T>
+      requires (std::is_lvalue_reference_v<T> or std::ranges::borrowed_range<std::remove_cvref_t<T>>)
+    auto add(std::string_view name, T&& data, part_options opt = {}) -> multipart& {
+      return this->add_part(name, opt, std::span<const char>(cpo::as_byte_seq(data)));
     }
-  };
 
-  template<detail::tag::has_reqbody_method MethodTag>
-  struct terse_req_impl<MethodTag> {
+    /**
+     * @brief ファイルの内容をパートとして追加する
+     * @details ファイルは送信中に読み出される、filenameの指定がない場合はパスのファイル名が使用される
+     */
+    auto add_file(std::string_view name, std::filesystem::path path, part_options opt = {}) -> multipart& {
+      return this->add_part(name, opt, std::move(path));
+    }
 
-    using tag_t = MethodTag;
+    /**
+     * @brief チャンクの範囲や読み出し関数から逐次読み出されるデータをパートとして追加する
+     * @param length パートの長さ、不明な場合はボディ全体がチャンク形式で送信される
+     */
+    template<body_source Source>
+      requires (not byte_serializable<Source>)
+    auto add_stream(std::string_view name, Source&& source, std::size_t length = detail::body_reader::unknown_length, part_options opt = {}) -> multipart& {
+      return this->add_part(name, opt, detail::make_body_reader(std::forward<Source>(source), length));
+    }
 
-    template<byte_serializable Body>
-    auto operator()(nt_string_view URL, Body&& request_body, request_config cfg = {}) const noexcept -> http_result {
-      // なければデフォ値をセット（実行時の状態に基づいて決められた方が良い・・・？
-      if (cfg.content_type.empty()) {
-        cfg.content_type = query_content_type<std::remove_cvref_t<Body>>;
-      }
-      // ここ、request_bodyの完全転送の必要あるかな・・・？
-      return chttpp::underlying::terse::request_impl(URL, std::move(cfg), cpo::as_byte_seq(request_body), MethodTag{});
+    auto parts() noexcept -> std::span<part> {
+      return m_parts;
     }
 
-    template<byte_serializable Body>
-    auto operator()(nt_wstring_view URL, Body&& request_body, request_config cfg = {}) const noexcept -> http_result {
-      // なければデフォ値をセット（実行時の状態に基づいて決められた方が良い・・・？
-      if (cfg.content_type.empty()) {
-        cfg.content_type = query_content_type<std::remove_cvref_t<Body>>;
-      }
-      return chttpp::underlying::terse::request_impl(URL, std::move(cfg), cpo::as_byte_seq(request_body), MethodTag{});
+    auto size() const noexcept -> std::size_t {
+      return m_parts.size();
     }
   };
-}
-
-namespace chttpp::inline method_object {
 
-  inline constexpr detail::terse_req_impl<detail::tag::get_t> get{};
-  inline constexpr detail::terse_req_impl<detail::tag::head_t> head{};
-  inline constexpr detail::terse_req_impl<detail::tag::options_t> options{};
-  inline constexpr detail::terse_req_impl<detail::tag::trace_t> trace{};
+  namespace detail {
 
-  inline constexpr detail::terse_req_impl<detail::tag::post_t> post{};
-  inline constexpr detail::terse_req_impl<detail::tag::put_t> put{};
-  inline constexpr detail::terse_req_impl<detail::tag::delete_t> delete_{};
-}
+    /**
+     * @brief 名前と値の組（std::pairなど）で、どちらも文字列として扱えるもの
+     */
+    template<typename T>
+    concept string_pair_like = requires(const T& t) {
+      requires std::tuple_size<std::remove_cvref_t<T>>::value == 2;
+      { std::get<0>(t) } -> std::convertible_to<std::string_view>;
+      { std::get<1>(t) } -> std::convertible_to<std::string_view>;
+    };
+  }
 
-namespace chttpp {
+  /**
+   * @brief application/x-www-form-urlencodedのリクエストボディ
+   * @details 構築時に全体の長さを求めてから、1つのバッファへ一度にエンコードする
+   * @details エンコードはRFC 3986の非予約文字以外をパーセントエンコードし、空白は+とする
+   */
+  class form_body {
+    string_t m_body{};
 
-  template<typename CharT>
-    requires requires {
-      requires std::is_same_v<CharT, char> or std::is_same_v<CharT, wchar_t>;
-    }
-  class agent {
-    using string = basic_string_t<CharT>;
-    using string_view = std::basic_string_view<CharT>;
+    /**
+     * @brief name=valueの列を、&で区切ってm_bodyへ書き込む
+     */
+    template<typename Fields>
+    void encode(const Fields& fields) {
+      std::size_t length = 0;
+      for (const auto& field : fields) {
+        length += detail::percent_encoded_size(std::get<0>(field), true) + detail::percent_encoded_size(std::get<1>(field), true) + 2;
+      }
 
-    // URLの頭の部分
-    string m_base_url;
+      if (length == 0) {
+        return;
+      }
 
-    // URLの変換に使用するバッファ（CharTによっては空のクラス）
-    [[no_unique_address]]
-    underlying::agent_impl::determin_buffer_t<CharT> convert_buffer{};
+      // 末尾の&の分は最後に取り除く
+      m_body.resize(length);
+      char* out = m_body.data();
 
-    // session_stateやバッファ等のリソースのまとめ
-    underlying::agent_impl::agent_resource m_resource;
+      for (const auto& field : fields) {
+        out = detail::percent_encode_to(out, std::get<0>(field), true);
+        *out++ = '=';
+        out = detail::percent_encode_to(out, std::get<1>(field), true);
+        *out++ = '&';
+      }
 
-    // 初期化や各種設定中に起きたエラーを記録する
-    detail::error_code m_config_ec;
+      m_body.pop_back();
+    }
 
-  // 基本関数群
   public:
 
-    [[nodiscard]]
-    agent(string_view base_url, detail::agent_initial_config initial_cfg = {})
-      : m_base_url(base_url)
-      , m_resource{ 
-                    .config = std::move(initial_cfg),
-                    .cookie_management = {chttpp::cookie_management::enable},
-                    .follow_redirect = {chttpp::follow_redirects::enable},
-                    .auto_decomp = {chttpp::automatic_decompression::enable},
-                    .request_url{underlying::to_string(m_base_url)}
-                  }
-      , m_config_ec{ m_resource.state.init(base_url, convert_buffer, m_resource.config) }
-    {
-      if (bool(m_config_ec) == false and m_resource.request_url.is_valid() == false) {
-        // 指定されたURLが変であるか、変換エラー
-        m_config_ec = detail::error_code{underlying::lib_error_code_tratis::url_error_value};
-      }
+    static constexpr std::string_view ContentType = "application/x-www-form-urlencoded";
+
+    form_body() = default;
+
+    /**
+     * @brief 名前と値の組の範囲から構築する
+     */
+    template<std::ranges::forward_range R>
+      requires detail::string_pair_like<std::ranges::range_reference_t<R>>
+    explicit form_body(R&& fields) {
+      this->encode(fields);
     }
 
-    agent(const agent&) = delete;
-    agent& operator=(const agent&) = delete;
+    form_body(std::initializer_list<std::pair<std::string_view, std::string_view>> fields) {
+      this->encode(fields);
+    }
 
-    agent(agent&&) = default;
-    agent& operator=(agent&&) & = default;
+    /**
+     * @brief コンパイル時に指定したフィールド名と、その値から構築する
+     * @details form_body::of<"user", "password">(user, password) のように使用する、フィールド名はコンパイル時にエンコードされる
+     */
+    template<detail::fixed_string... Names, std::convertible_to<std::string_view>... Values>
+      requires (sizeof...(Names) == sizeof...(Values))
+    static auto of(const Values&... values) -> form_body {
+      // "name=" をコンパイル時にエンコードしたもの
+      constexpr auto encoded_names = [] {
+        constexpr std::size_t length = ((detail::percent_encoded_size(Names.view(), true) + 1) + ... + 0);
+        std::array<char, length> buffer{};
+        std::array<std::size_t, sizeof...(Names) + 1> offsets{};
+
+        char* out = buffer.data();
+        std::size_t i = 0;
+        ((out = detail::percent_encode_to(out, Names.view(), true), *out++ = '=', offsets[++i] = static_cast<std::size_t>(out - buffer.data())), ...);
+
+        return std::pair{buffer, offsets};
+      }();
+
+      const std::array<std::string_view, sizeof...(Values)> value_views{ std::string_view(values)... };
+
+      std::size_t length = encoded_names.first.size() + sizeof...(Values);
+      for (const auto value : value_views) {
+        length += detail::percent_encoded_size(value, true);
+      }
 
-    template<auto Method>
-    auto request(string_view url_path, detail::agent_request_config req_cfg = {}) & noexcept -> detail::http_result {
-      using tag = decltype(Method)::tag_t;
+      form_body body{};
+      if constexpr (0 < sizeof...(Names)) {
+        body.m_body.resize(length);
+        char* out = body.m_body.data();
 
-      if (m_config_ec) {
-        return detail::http_result{m_config_ec};
+        for (std::size_t i = 0; i < value_views.size(); ++i) {
+          const auto& [names, offsets] = encoded_names;
+          out = std::ranges::copy(names.begin() + offsets[i], names.begin() + offsets[i + 1], out).out;
+          out = detail::percent_encode_to(out, value_views[i], true);
+          *out++ = '&';
+        }
+
+        body.m_body.pop_back();
       }
 
-      return underlying::agent_impl::request_impl(url_path, convert_buffer, m_resource, std::move(req_cfg), std::span<const char>{}, tag{});
+      return body;
     }
 
-    template<auto Method>
-    auto request(detail::agent_request_config req_cfg = {}) & noexcept -> detail::http_result {
-      return request<Method>("", std::move(req_cfg));
+    auto as_byte_seq() const noexcept -> std::span<const char> {
+      return m_body;
     }
 
-    template<auto Method, byte_serializable Body>
-      requires detail::tag::has_reqbody_method<typename decltype(Method)::tag_t>
-    auto request(string_view url_path, Body&& request_body, detail::agent_request_config req_cfg = {}) & noexcept -> detail::http_result {
-      using tag = decltype(Method)::tag_t;
+    auto str() const noexcept -> std::string_view {
+      return m_body;
+    }
+  };
 
-      if (m_config_ec) {
-        return detail::http_result{m_config_ec};
-      }
+  /**
+   * @brief レスポンスボディを固定長レコードの列として逐次受け取る、streaming_receiverに指定する
+   * @tparam T レコード型
+   * @tparam F std::span<const T>を受けて呼び出し可能な型
+   * @details チャンク境界をまたいだレコードはつなぎ合わせてから渡すので、コールバックには完全なレコードだけが渡される
+   * @details チャンクのアライメントがTに適合していればコピーせずにそのまま渡す
+   * @details 転送終了時に残った不完全なレコードは渡されない（pending_bytes()で確認できる）
+   */
+  template<detail::substantial T, std::invocable<std::span<const T>> F>
+  class record_receiver {
+    F m_callback;
 
-      // なければデフォ値をセット（実行時の状態に基づいて決められた方が良い・・・？
-      // ヘッダで指定してた時はこれどうなるの？？
-      if (req_cfg.content_type.empty()) {
-        req_cfg.content_type = query_content_type<std::remove_cvref_t<Body>>;
-      }
+    // チャンク境界をまたいだレコードの断片
+    alignas(T) char m_partial[sizeof(T)]{};
+    std::size_t m_partial_len = 0;
 
-      return underlying::agent_impl::request_impl(url_path, convert_buffer, m_resource, std::move(req_cfg), cpo::as_byte_seq(request_body), tag{});
-    }
+    // アライメントが揃っていないチャンクを読み替えるためのバッファ
+    vector_t<T> m_staging{};
 
-    template<auto Method, byte_serializable Body>
-      requires detail::tag::has_reqbody_method<typename decltype(Method)::tag_t> and
-               (not std::is_same_v<Body, detail::agent_request_config>)
-    auto request(Body&& request_body, detail::agent_request_config req_cfg = {}) & noexcept -> detail::http_result {
-      return request<Method>("", std::forward<Body>(request_body), std::move(req_cfg));
-    }
+  public:
 
-    auto get(string_view url_path, detail::agent_request_config req_cfg = {}) & noexcept -> detail::http_result {
-      return this->request<::chttpp::get>(url_path, std::move(req_cfg));
-    }
+    explicit record_receiver(F callback)
+      : m_callback(std::move(callback))
+    {}
 
-    auto get(detail::agent_request_config req_cfg = {}) & noexcept -> detail::http_result {
-      return this->request<::chttpp::get>("", std::move(req_cfg));
-    }
+    void operator()(std::span<const char> chunk) {
+      // 前回の断片があれば、まずそれを埋める
+      if (m_partial_len != 0) {
+        const std::size_t fill_len = std::min(sizeof(T) - m_partial_len, chunk.size());
+        std::memcpy(m_partial + m_partial_len, chunk.data(), fill_len);
 
-    auto post(string_view url_path, byte_serializable auto&& request_body, detail::agent_request_config req_cfg = {}) & noexcept -> detail::http_result {
-      return this->request<::chttpp::post>(url_path, request_body, std::move(req_cfg));
-    }
+        m_partial_len += fill_len;
+        chunk = chunk.subspan(fill_len);
+
+        if (m_partial_len < sizeof(T)) {
+          // まだ埋まらない
+          return;
+        }
+
+        T record{};
+        cpo::load_byte_seq(record, std::span<const char>{m_partial});
+        m_partial_len = 0;
+
+        std::invoke(m_callback, std::span<const T>{std::addressof(record), 1});
+      }
+
+      const std::size_t count = chunk.size() / sizeof(T);
+      const std::size_t complete_len = count * sizeof(T);
+
+      if (count != 0) {
+        if (reinterpret_cast<std::uintptr_t>(chunk.data()) % alignof(T) == 0) {
+          // アライメントが揃っていれば、そのまま読み替えて渡す
+          std::invoke(m_callback, std::span<const T>{reinterpret_cast<const T*>(chunk.data()), count});
+        } else {
+          m_staging.resize(count);
+          cpo::load_byte_seq(m_staging, chunk.first(complete_len));
+
+          std::invoke(m_callback, std::span<const T>{m_staging});
+        }
+      }
+
+      // 余りは次のチャンクに持ち越す
+      m_partial_len = chunk.size() - complete_len;
+      std::memcpy(m_partial, chunk.data() + complete_len, m_partial_len);
+    }
+
+    /**
+     * @brief 次のチャンクへ持ち越されている不完全なレコードのバイト数
+     */
+    [[nodiscard]]
+    auto pending_bytes() const noexcept -> std::size_t {
+      return m_partial_len;
+    }
+  };
+
+  /**
+   * @brief record_receiverを作成する
+   * @details agent.get(path, { .streaming_receiver = chttpp::receive_records<T>(callback) }) のように使用する
+   */
+  template<detail::substantial T, std::invocable<std::span<const T>> F>
+  auto receive_records(F&& callback) -> record_receiver<T, std::decay_t<F>> {
+    return record_receiver<T, std::decay_t<F>>{std::forward<F>(callback)};
+  }
+
+  /**
+   * @brief 区切られたレコードを1つずつ受け取ることのできる型
+   * @details 戻り値型はvoidもしくはreceive_status
+   */
+  template<typename F>
+  concept delimited_record_handler =
+    std::invocable<F&, std::string_view> and
+    (std::same_as<std::invoke_result_t<F&, std::string_view>, void> or
+     std::same_as<std::invoke_result_t<F&, std::string_view>, receive_status>);
+
+  /**
+   * @brief レスポンスボディを区切り文字で分割し、レコード毎に逐次受け取る、body_receiverとして使用する
+   * @tparam F std::string_viewを受けて呼び出し可能な型
+   * @details 区切り文字の探索はmemchrで行い、チャンク内で完結するレコードはコピーせずに渡す
+   * @details チャンク境界をまたいだレコードだけをつなぎ合わせてから渡す（そのためのバッファは使いまわされる）
+   * @details 転送終了時に区切り文字で終わっていないレコードは、finish()を呼ぶまで渡されない
+   * @details コールバックがreceive_status::pauseを返した場合、再開後に渡される同じチャンクはそのレコードの直後から処理する
+   */
+  template<delimited_record_handler F>
+  class delimited_receiver {
+    F m_callback;
+    char m_delimiter;
+    // 各レコード末尾の\rを取り除く
+    bool m_strip_cr;
+
+    // チャンク境界をまたいだレコードの断片
+    string_t m_partial{};
+    // pauseした場合に、再度渡されるチャンクの処理済みの長さ
+    std::size_t m_resume_offset = 0;
+
+    auto invoke(std::string_view record) -> receive_status {
+      if (m_strip_cr and record.ends_with('\r')) {
+        record.remove_suffix(1);
+      }
+
+      if constexpr (std::same_as<std::invoke_result_t<F&, std::string_view>, void>) {
+        std::invoke(m_callback, record);
+        return receive_status::proceed;
+      } else {
+        return std::invoke(m_callback, record);
+      }
+    }
+
+  public:
+
+    delimited_receiver(F callback, char delimiter, bool strip_cr)
+      : m_callback(std::forward<F>(callback))
+      , m_delimiter(delimiter)
+      , m_strip_cr(strip_cr)
+    {}
+
+    auto operator()(std::span<const char> chunk) -> receive_status {
+      const char* const first = chunk.data();
+      const char* const last = first + chunk.size();
+      const char* pos = first + std::exchange(m_resume_offset, 0);
+
+      while (pos != last) {
+        const auto* found = static_cast<const char*>(std::memchr(pos, m_delimiter, static_cast<std::size_t>(last - pos)));
+
+        if (found == nullptr) {
+          m_partial.append(pos, last);
+          break;
+        }
+
+        std::string_view record{pos, found};
+
+        if (not m_partial.empty()) {
+          m_partial.append(record);
+          record = m_partial;
+        }
+
+        const auto status = this->invoke(record);
+        m_partial.clear();
+        pos = found + 1;
+
+        if (status == receive_status::abort) {
+          return status;
+        }
+
+        if (status == receive_status::pause) {
+          m_resume_offset = static_cast<std::size_t>(pos - first);
+          return status;
+        }
+      }
+
+      return receive_status::proceed;
+    }
+
+    /**
+     * @brief 区切り文字で終わっていない最後のレコードがあれば、それを渡す
+     * @details 転送の終了後に呼び出す
+     */
+    auto finish() -> receive_status {
+      if (m_partial.empty()) {
+        return receive_status::proceed;
+      }
+
+      const auto status = this->invoke(m_partial);
+      m_partial.clear();
+
+      return status;
+    }
+
+    /**
+     * @brief 次のチャンクへ持ち越されている不完全なレコードのバイト数
+     */
+    [[nodiscard]]
+    auto pending_bytes() const noexcept -> std::size_t {
+      return m_partial.size();
+    }
+  };
+
+  /**
+   * @brief 行毎にレスポンスボディを受け取るdelimited_receiverを作成する
+   * @details 改行は\nもしくは\r\nとし、コールバックには改行を含まない行が渡される
+   * @details agent.get(path, chttpp::receive_lines(callback)) のように使用する（NDJSONなど）
+   */
+  template<delimited_record_handler F>
+  auto receive_lines(F&& callback) -> delimited_receiver<std::decay_t<F>> {
+    return delimited_receiver<std::decay_t<F>>{std::forward<F>(callback), '\n', true};
+  }
+
+  /**
+   * @brief 指定した区切り文字で区切られたレコード毎にレスポンスボディを受け取るdelimited_receiverを作成する
+   */
+  template<delimited_record_handler F>
+  auto receive_delimited(char delimiter, F&& callback) -> delimited_receiver<std::decay_t<F>> {
+    return delimited_receiver<std::decay_t<F>>{std::forward<F>(callback), delimiter, false};
+  }
+}
+
+namespace chttpp::views {
+
+  /**
+   * @brief 文字列を区切り文字で分割したレコードの列
+   * @details 要素はstd::string_viewで、元の文字列を参照する（区切り文字は含まない）
+   * @details 末尾が区切り文字で終わる場合、その後ろの空のレコードは含まれない
+   * @details 区切り文字の探索はmemchrで行う
+   */
+  class record_view : public std::ranges::view_interface<record_view> {
+    std::string_view m_str{};
+    char m_delimiter = '\n';
+    bool m_strip_cr = false;
+
+    class iterator {
+      // 次のレコードの先頭
+      const char* m_next = nullptr;
+      const char* m_last = nullptr;
+      std::string_view m_current{};
+      char m_delimiter = '\n';
+      bool m_strip_cr = false;
+      bool m_done = true;
+
+      void advance() {
+        if (m_next == m_last) {
+          m_done = true;
+          return;
+        }
+
+        const auto* found = static_cast<const char*>(std::memchr(m_next, m_delimiter, static_cast<std::size_t>(m_last - m_next)));
+        const char* record_end = found != nullptr ? found : m_last;
+
+        m_current = std::string_view{m_next, record_end};
+        m_next = found != nullptr ? found + 1 : m_last;
+
+        if (m_strip_cr and m_current.ends_with('\r')) {
+          m_current.remove_suffix(1);
+        }
+      }
+
+    public:
+
+      using iterator_concept = std::forward_iterator_tag;
+      using iterator_category = std::input_iterator_tag;
+      using value_type = std::string_view;
+      using difference_type = std::ptrdiff_t;
+
+      iterator() = default;
+
+      iterator(std::string_view str, char delimiter, bool strip_cr)
+        : m_next(str.data())
+        , m_last(str.data() + str.size())
+        , m_delimiter(delimiter)
+        , m_strip_cr(strip_cr)
+        , m_done(false)
+      {
+        this->advance();
+      }
+
+      auto operator*() const noexcept -> std::string_view {
+        return m_current;
+      }
+
+      auto operator++() -> iterator& {
+        this->advance();
+        return *this;
+      }
+
+      auto operator++(int) -> iterator {
+        auto copy = *this;
+        this->advance();
+        return copy;
+      }
+
+      friend bool operator==(const iterator& lhs, const iterator& rhs) noexcept {
+        if (lhs.m_done or rhs.m_done) {
+          return lhs.m_done == rhs.m_done;
+        }
+        return lhs.m_current.data() == rhs.m_current.data();
+      }
+
+      friend bool operator==(const iterator& it, std::default_sentinel_t) noexcept {
+        return it.m_done;
+      }
+    };
+
+  public:
+
+    record_view() = default;
+
+    record_view(std::string_view str, char delimiter, bool strip_cr = false)
+      : m_str(str)
+      , m_delimiter(delimiter)
+      , m_strip_cr(strip_cr)
+    {}
+
+    auto begin() const -> iterator {
+      return iterator{m_str, m_delimiter, m_strip_cr};
+    }
+
+    auto end() const noexcept -> std::default_sentinel_t {
+      return std::default_sentinel;
+    }
+  };
+
+  namespace detail {
+
+    /**
+     * @brief 文字列（もしくはhttp_result）をrecord_viewに変換するパイプ用の関数オブジェクト
+     */
+    struct record_adaptor {
+      char delimiter;
+      bool strip_cr;
+
+      auto operator()(std::string_view str) const -> record_view {
+        return record_view{str, delimiter, strip_cr};
+      }
+
+      friend auto operator|(std::string_view str, const record_adaptor& self) -> record_view {
+        return self(str);
+      }
+    };
+
+    struct records_fn {
+      constexpr auto operator()(char delimiter) const noexcept -> record_adaptor {
+        return record_adaptor{delimiter, false};
+      }
+    };
+  }
+
+  /**
+   * @brief 行（\nもしくは\r\n区切り）の列に変換する
+   * @details res | chttpp::views::lines のように使用する
+   * @details 結果のviewは元の文字列（レスポンスボディ）を参照するので、http_resultは一時オブジェクトであってはならない
+   */
+  inline constexpr detail::record_adaptor lines{'\n', true};
+
+  /**
+   * @brief 指定した区切り文字で区切られたレコードの列に変換する
+   * @details res | chttpp::views::records(',') のように使用する
+   */
+  inline constexpr detail::records_fn records{};
+}
+
+namespace std::ranges {
+  template<>
+  inline constexpr bool enable_borrowed_range<chttpp::views::record_view> = true;
+}
+
+namespace chttpp::detail {
+
+  /**
+   * @brief Digest系ヘッダで用いられるハッシュアルゴリズム名（小文字）
+   * @details 登録されたものがないアルゴリズムは空
+   */
+  template<typename Algorithm>
+  inline constexpr std::string_view digest_algorithm_name = "";
+
+  template<>
+  inline constexpr std::string_view digest_algorithm_name<digest::sha256> = "sha-256";
+
+  template<>
+  inline constexpr std::string_view digest_algorithm_name<digest::md5> = "md5";
+
+  template<>
+  inline constexpr std::string_view digest_algorithm_name<digest::crc32c> = "crc32c";
+
+  /**
+   * @brief Content-Digest/Repr-Digest（RFC 9530）もしくはDigest（RFC 3230）ヘッダの値から、指定したアルゴリズムの値を取り出す
+   * @param field_value ヘッダの値、"sha-256=:base64:, md5=:base64:" もしくは "SHA-256=base64,MD5=base64"
+   * @param algorithm 小文字のアルゴリズム名
+   * @return base64文字列、見つからなければ空
+   */
+  inline auto find_digest_value(std::string_view field_value, std::string_view algorithm) -> std::string_view {
+    constexpr auto trim = [](std::string_view str) {
+      const auto first = str.find_first_not_of(" \t");
+      if (first == std::string_view::npos) {
+        return std::string_view{};
+      }
+      return str.substr(first, str.find_last_not_of(" \t") - first + 1);
+    };
+
+    while (not field_value.empty()) {
+      const auto sep_pos = field_value.find(',');
+      auto member = field_value.substr(0, sep_pos);
+      field_value = sep_pos == std::string_view::npos ? std::string_view{} : field_value.substr(sep_pos + 1);
+
+      // パラメータは使用しない
+      member = member.substr(0, member.find(';'));
+
+      // base64のパディングも=なので、最初の=で区切る
+      const auto eq_pos = member.find('=');
+      if (eq_pos == std::string_view::npos) {
+        continue;
+      }
+
+      const auto name = trim(member.substr(0, eq_pos));
+      const bool same_name = std::ranges::equal(name, algorithm, [](char lhs, char rhs) {
+        return std::tolower(static_cast<unsigned char>(lhs)) == rhs;
+      });
+
+      if (not same_name) {
+        continue;
+      }
+
+      auto value = trim(member.substr(eq_pos + 1));
+
+      // RFC 9530ではバイト列として:で囲まれている
+      if (2 <= value.size() and value.front() == ':' and value.back() == ':') {
+        value = value.substr(1, value.size() - 2);
+      }
+
+      return value;
+    }
+
+    return {};
+  }
+}
+
+namespace chttpp::sinks {
+
+  /**
+   * @brief 受信したチャンクを、複数のbody_receiverへ順番に渡す
+   * @details 各チャンクは1度だけ受信され、キャッシュに載っている間に全てのreceiverへ渡される
+   * @details いずれかがabortを返すとそこで中断し、転送も中断される
+   * @details いずれかがpauseを返すと転送を一時停止し、再開後に渡される同じチャンクはそのreceiverから渡し直す
+   */
+  template<detail::body_receiver... Receivers>
+  class tee_sink {
+    std::tuple<Receivers...> m_receivers;
+
+    // 一時停止したreceiverの位置、これより前のreceiverは現在のチャンクを受け取り済み
+    std::size_t m_resume_from = 0;
+
+    template<std::size_t I>
+    auto feed(std::span<const char> chunk, receive_status& status) -> bool {
+      if (I < m_resume_from) {
+        return true;
+      }
+
+      status = detail::invoke_receiver(std::get<I>(m_receivers), chunk);
+
+      if (status == receive_status::pause) {
+        m_resume_from = I;
+      }
+
+      return status == receive_status::proceed;
+    }
+
+  public:
+
+    template<typename... Args>
+    explicit tee_sink(Args&&... receivers)
+      : m_receivers(std::forward<Args>(receivers)...)
+    {}
+
+    auto operator()(std::span<const char> chunk) -> receive_status {
+      auto status = receive_status::proceed;
+
+      [&]<std::size_t... I>(std::index_sequence<I...>) {
+        (this->feed<I>(chunk, status) and ...);
+      }(std::index_sequence_for<Receivers...>{});
+
+      if (status == receive_status::proceed) {
+        m_resume_from = 0;
+      }
+
+      return status;
+    }
+  };
+
+  /**
+   * @brief tee_sinkを作成する
+   * @details 左辺値で渡したreceiverは参照で保持されるので、転送後にその結果（ハッシュ値など）を参照できる
+   * @details agent.get(path, chttpp::sinks::tee(file, sha256, parser)) のように使用する
+   */
+  template<typename... Receivers>
+    requires (detail::body_receiver<Receivers> and ...)
+  auto tee(Receivers&&... receivers) -> tee_sink<Receivers...> {
+    return tee_sink<Receivers...>{std::forward<Receivers>(receivers)...};
+  }
+
+  /**
+   * @brief 受信したチャンクをそのままファイルに書き込む
+   * @details 書き込みに失敗した場合（ファイルを開けなかった場合も含む）、転送を中断する
+   */
+  class file_sink {
+    std::ofstream m_file;
+    std::uint64_t m_written = 0;
+
+  public:
+
+    explicit file_sink(const std::filesystem::path& file_path)
+      : m_file(file_path, std::ios::binary | std::ios::trunc)
+    {}
+
+    auto operator()(std::span<const char> chunk) -> receive_status {
+      if (not m_file.write(chunk.data(), static_cast<std::streamsize>(chunk.size()))) {
+        return receive_status::abort;
+      }
+
+      m_written += chunk.size();
+      return receive_status::proceed;
+    }
+
+    /**
+     * @brief ここまでの書き込みが全て成功しているか
+     */
+    explicit operator bool() const {
+      return bool(m_file);
+    }
+
+    /**
+     * @brief 書き込んだバイト数
+     */
+    auto bytes_written() const noexcept -> std::uint64_t {
+      return m_written;
+    }
+
+    /**
+     * @brief バッファをフラッシュしてファイルを閉じる
+     */
+    void close() {
+      m_file.close();
+    }
+  };
+
+  /**
+   * @brief 受信したボディとDigest系ヘッダの照合結果
+   */
+  enum class digest_check {
+    // 一致した
+    matched,
+    // 一致しなかった
+    mismatched,
+    // 照合できるヘッダがなかった
+    absent,
+  };
+
+  /**
+   * @brief 受信したチャンクからハッシュ値（チェックサム）を計算する
+   * @tparam Algorithm chttpp::digest以下のハッシュアルゴリズム
+   * @details verify()によって、Content-Digest/Repr-Digest/Digest（MD5はContent-MD5も）ヘッダの値と照合できる
+   * @details それらのヘッダの値はContent-Encoding適用後のバイト列に対するものなので、自動展開されたボディとは一致しない
+   */
+  template<typename Algorithm>
+  class digest_sink {
+    Algorithm m_algorithm{};
+
+  public:
+
+    using result_type = typename Algorithm::result_type;
+
+    static constexpr std::string_view algorithm_name = detail::digest_algorithm_name<Algorithm>;
+
+    void operator()(std::span<const char> chunk) noexcept {
+      m_algorithm.update(chunk);
+    }
+
+    /**
+     * @brief ここまでに受信したデータのハッシュ値
+     */
+    auto value() const noexcept -> result_type {
+      return m_algorithm.value();
+    }
+
+    auto hex() const -> std::string {
+      return digest::to_hex(value());
+    }
+
+    auto base64() const -> std::string {
+      return digest::to_base64(value());
+    }
+
+    /**
+     * @brief レスポンスヘッダの値とハッシュ値を照合する
+     * @details 複数のヘッダがある場合、Content-Digest、Repr-Digest、Digestの順で最初に見つかったものと照合する
+     */
+    auto verify(const header_t& headers) const -> digest_check {
+      using namespace std::string_view_literals;
+
+      const auto expected = this->base64();
+
+      if constexpr (not algorithm_name.empty()) {
+        for (const auto field_name : { "content-digest"sv, "repr-digest"sv, "digest"sv }) {
+          const auto pos = headers.find(field_name);
+          if (pos == headers.end()) {
+            continue;
+          }
+
+          if (const auto value = detail::find_digest_value((*pos).second, algorithm_name); not value.empty()) {
+            return value == expected ? digest_check::matched : digest_check::mismatched;
+          }
+        }
+      }
+
+      if constexpr (std::same_as<Algorithm, digest::md5>) {
+        if (const auto pos = headers.find("content-md5"sv); pos != headers.end()) {
+          return std::string_view{(*pos).second} == expected ? digest_check::matched : digest_check::mismatched;
+        }
+      }
+
+      return digest_check::absent;
+    }
+
+    auto verify(const detail::http_response& response) const -> digest_check {
+      return this->verify(response.headers);
+    }
+  };
+
+  using sha256_sink = digest_sink<digest::sha256>;
+  using md5_sink = digest_sink<digest::md5>;
+  using crc32_sink = digest_sink<digest::crc32>;
+  using crc32c_sink = digest_sink<digest::crc32c>;
+}
+
+namespace chttpp {
+
+  /**
+   * @brief Server-Sent Eventsの1つのイベント
+   * @details 各メンバはイベントハンドラの呼び出し中のみ有効
+   */
+  struct sse_event {
+    // eventフィールドの値（指定されていなければ"message"）
+    std::string_view type;
+    // dataフィールドの値（複数行の場合は\nで連結される）
+    std::string_view data;
+    // このイベントまでに受け取った最後のid
+    std::string_view id;
+  };
+
+  /**
+   * @brief sse_eventを受け取ることのできる型
+   * @details 戻り値型はvoidもしくはreceive_status
+   */
+  template<typename F>
+  concept sse_handler =
+    std::invocable<F&, const sse_event&> and
+    (std::same_as<std::invoke_result_t<F&, const sse_event&>, void> or
+     std::same_as<std::invoke_result_t<F&, const sse_event&>, receive_status>);
+
+  /**
+   * @brief text/event-streamのレスポンスボディを逐次パースし、イベント毎にハンドラを呼び出す、body_receiverとして使用する
+   * @tparam F sse_handler
+   * @details イベントは終端の空行を受信したチャンクの処理中に通知され、後続のデータを待つことはない
+   * @details チャンク内で完結する行はコピーせずに処理し、チャンク境界をまたぐ行と複数行のdataだけを内部バッファに保持する
+   * @details 内部バッファは使いまわされるため、定常状態ではイベント毎のメモリ確保は発生しない
+   * @details ハンドラがreceive_status::pauseを返した場合、再開後に渡される同じチャンクはそのイベントの直後から処理する
+   */
+  template<sse_handler F>
+  class sse_parser {
+    F m_handler;
+
+    // チャンク境界をまたいだ行の断片
+    string_t m_line{};
+    // 行末の\rを受け取った直後の\nを読み飛ばす
+    bool m_skip_lf = false;
+    // ストリーム先頭のBOMを確認済み
+    bool m_bom_checked = false;
+
+    // 現在のイベントのdata、m_data_ownedがfalseの場合は現在のチャンクを指す
+    std::string_view m_data{};
+    string_t m_data_buffer{};
+    bool m_has_data = false;
+    bool m_data_owned = false;
+
+    string_t m_event_type{};
+    string_t m_id_buffer{};
+    string_t m_last_event_id{};
+    std::optional<std::chrono::milliseconds> m_retry{};
+
+    // pauseした場合に、再度渡されるチャンクの処理済みの長さ
+    std::size_t m_resume_offset = 0;
+
+    /**
+     * @brief dataを内部バッファへ移し、チャンクを参照しないようにする
+     */
+    void own_data() {
+      if (m_has_data and not m_data_owned) {
+        m_data_buffer.assign(m_data);
+        m_data = m_data_buffer;
+        m_data_owned = true;
+      }
+    }
+
+    void append_data(std::string_view value, bool from_chunk) {
+      if (not m_has_data and from_chunk) {
+        // 1行だけのdataはチャンクを直接参照する
+        m_data = value;
+        m_has_data = true;
+        m_data_owned = false;
+        return;
+      }
+
+      if (m_has_data) {
+        own_data();
+        m_data_buffer.push_back('\n');
+      } else {
+        m_data_buffer.clear();
+      }
+
+      m_data_buffer.append(value);
+      m_data = m_data_buffer;
+      m_has_data = true;
+      m_data_owned = true;
+    }
+
+    auto dispatch() -> receive_status {
+      m_last_event_id.assign(m_id_buffer);
+
+      if (not m_has_data) {
+        m_event_type.clear();
+        return receive_status::proceed;
+      }
+
+      const sse_event event{
+        .type = m_event_type.empty() ? std::string_view{"message"} : std::string_view{m_event_type},
+        .data = m_data,
+        .id = m_last_event_id
+      };
+
+      auto status = receive_status::proceed;
+
+      if constexpr (std::same_as<std::invoke_result_t<F&, const sse_event&>, void>) {
+        std::invoke(m_handler, event);
+      } else {
+        status = std::invoke(m_handler, event);
+      }
+
+      m_has_data = false;
+      m_data_owned = false;
+      m_data = {};
+      m_event_type.clear();
+
+      return status;
+    }
+
+    /**
+     * @brief 1行（改行を含まない）を処理する
+     * @param from_chunk 行が現在のチャンクを直接参照しているか
+     */
+    auto process_line(std::string_view line, bool from_chunk) -> receive_status {
+      if (line.empty()) {
+        return dispatch();
+      }
+
+      if (line.front() == ':') {
+        // コメント
+        return receive_status::proceed;
+      }
+
+      const auto colon_pos = line.find(':');
+      const auto field = line.substr(0, colon_pos);
+      auto value = colon_pos == std::string_view::npos ? std::string_view{} : line.substr(colon_pos + 1);
+
+      if (value.starts_with(' ')) {
+        value.remove_prefix(1);
+      }
+
+      if (field == "data") {
+        append_data(value, from_chunk);
+      } else if (field == "event") {
+        m_event_type.assign(value);
+      } else if (field == "id") {
+        if (value.find('\0') == std::string_view::npos) {
+          m_id_buffer.assign(value);
+        }
+      } else if (field == "retry") {
+        std::uint64_t ms = 0;
+        if (const auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), ms); ec == std::errc{} and ptr == value.data() + value.size() and not value.empty()) {
+          m_retry = std::chrono::milliseconds{ms};
+        }
+      }
+
+      return receive_status::proceed;
+    }
+
+  public:
+
+    explicit sse_parser(F handler)
+      : m_handler(std::forward<F>(handler))
+    {}
+
+    auto operator()(std::span<const char> chunk_span) -> receive_status {
+      std::string_view chunk{chunk_span.data(), chunk_span.size()};
+
+      // 一時停止前に処理した部分は読み飛ばす
+      std::size_t pos = std::exchange(m_resume_offset, 0);
+
+      if (m_skip_lf and pos < chunk.size()) {
+        if (chunk[pos] == '\n') {
+          ++pos;
+        }
+        m_skip_lf = false;
+      }
+
+      while (pos < chunk.size()) {
+        const auto eol_pos = chunk.find_first_of("\r\n", pos);
+
+        if (eol_pos == std::string_view::npos) {
+          // 行の途中でチャンクが終わった
+          m_line.append(chunk.substr(pos));
+          break;
+        }
+
+        const bool from_chunk = m_line.empty();
+        std::string_view line = chunk.substr(pos, eol_pos - pos);
+
+        if (not from_chunk) {
+          m_line.append(line);
+          line = m_line;
+        }
+
+        // ストリーム先頭のBOMは無視する
+        if (not m_bom_checked) {
+          if (line.starts_with("\xEF\xBB\xBF")) {
+            line.remove_prefix(3);
+          }
+          m_bom_checked = true;
+        }
+
+        const auto status = process_line(line, from_chunk);
+        m_line.clear();
+
+        pos = eol_pos + 1;
+
+        if (chunk[eol_pos] == '\r') {
+          if (pos == chunk.size()) {
+            m_skip_lf = true;
+          } else if (chunk[pos] == '\n') {
+            ++pos;
+          }
+        }
+
+        if (status == receive_status::abort) {
+          return status;
+        }
+
+        if (status == receive_status::pause) {
+          m_resume_offset = pos;
+          own_data();
+          return status;
+        }
+      }
+
+      // 次のチャンクではこのチャンクを参照できない
+      own_data();
+
+      return receive_status::proceed;
+    }
+
+    /**
+     * @brief 受信途中のイベントを破棄する、再接続の前に呼び出す
+     * @details 最後のidとretryの値は保持される
+     */
+    void reset() {
+      m_line.clear();
+      m_skip_lf = false;
+      m_bom_checked = false;
+      m_has_data = false;
+      m_data_owned = false;
+      m_data = {};
+      m_event_type.clear();
+      m_id_buffer.assign(m_last_event_id);
+      m_resume_offset = 0;
+    }
+
+    /**
+     * @brief 最後に通知されたイベントのid、再接続時のLast-Event-IDとして使用する
+     */
+    auto last_event_id() const noexcept -> std::string_view {
+      return m_last_event_id;
+    }
+
+    void last_event_id(std::string_view id) {
+      m_last_event_id.assign(id);
+      m_id_buffer.assign(id);
+    }
+
+    /**
+     * @brief サーバーから指定された再接続までの待機時間
+     */
+    auto retry() const noexcept -> std::optional<std::chrono::milliseconds> {
+      return m_retry;
+    }
+  };
+
+  /**
+   * @brief sse_parserを作成する
+   * @details 左辺値で渡したハンドラは参照で保持する
+   * @details agent.get(path, chttpp::parse_sse(handler)) のように使用する
+   */
+  template<sse_handler F>
+  auto parse_sse(F&& handler) -> sse_parser<F> {
+    return sse_parser<F>{std::forward<F>(handler)};
+  }
+}
+
+namespace chttpp {
+
+  /**
+   * @brief Content-Typeヘッダの値からmultipartのboundaryパラメータを取り出す
+   * @return boundary、見つからなければ空
+   */
+  inline auto multipart_boundary(std::string_view content_type) noexcept -> std::string_view {
+    using namespace std::string_view_literals;
+
+    while (not content_type.empty()) {
+      const auto param_pos = content_type.find(';');
+      if (param_pos == std::string_view::npos) {
+        break;
+      }
+      content_type.remove_prefix(param_pos + 1);
+
+      const auto name_pos = content_type.find_first_not_of(" \t");
+      if (name_pos == std::string_view::npos) {
+        break;
+      }
+      content_type.remove_prefix(name_pos);
+
+      constexpr auto name = "boundary="sv;
+      const bool is_boundary = content_type.size() >= name.size() and std::ranges::equal(content_type.substr(0, name.size()), name, [](char lhs, char rhs) {
+        return std::tolower(static_cast<unsigned char>(lhs)) == rhs;
+      });
+
+      if (not is_boundary) {
+        continue;
+      }
+
+      content_type.remove_prefix(name.size());
+
+      if (content_type.starts_with('"')) {
+        return content_type.substr(1, content_type.find('"', 1) - 1);
+      }
+
+      return content_type.substr(0, content_type.find_first_of("; \t"));
+    }
+
+    return {};
+  }
+
+  /**
+   * @brief multipartボディの1つのパートのヘッダ
+   * @details ヘッダはパートのボディの受信中のみ有効
+   */
+  class multipart_part {
+    std::size_t m_index;
+    // パートのヘッダ全体（各行は\r\nで終わる）
+    std::string_view m_headers;
+
+  public:
+
+    multipart_part(std::size_t index, std::string_view headers) noexcept
+      : m_index(index)
+      , m_headers(headers)
+    {}
+
+    /**
+     * @brief 0から始まるパートの番号
+     */
+    auto index() const noexcept -> std::size_t {
+      return m_index;
+    }
+
+    /**
+     * @brief ヘッダの値を取得する
+     * @param name ヘッダ名（大文字小文字は区別しない）
+     * @return 値、存在しなければ空
+     */
+    auto header(std::string_view name) const noexcept -> std::string_view {
+      std::string_view rest = m_headers;
+
+      while (not rest.empty()) {
+        const auto eol_pos = rest.find("\r\n");
+        const auto line = rest.substr(0, eol_pos);
+        rest = eol_pos == std::string_view::npos ? std::string_view{} : rest.substr(eol_pos + 2);
+
+        const auto colon_pos = line.find(':');
+        if (colon_pos == std::string_view::npos) {
+          continue;
+        }
+
+        const bool same_name = std::ranges::equal(line.substr(0, colon_pos), name, [](char lhs, char rhs) {
+          return std::tolower(static_cast<unsigned char>(lhs)) == std::tolower(static_cast<unsigned char>(rhs));
+        });
+
+        if (same_name) {
+          const auto value = line.substr(colon_pos + 1);
+          const auto first = value.find_first_not_of(" \t");
+          return first == std::string_view::npos ? std::string_view{} : value.substr(first, value.find_last_not_of(" \t") - first + 1);
+        }
+      }
+
+      return {};
+    }
+
+    auto content_type() const noexcept -> std::string_view {
+      return this->header("content-type");
+    }
+
+    /**
+     * @brief multipart/byterangesの各パートのContent-Range
+     */
+    auto content_range() const noexcept -> std::optional<detail::content_range> {
+      return detail::parse_content_range(this->header("content-range"));
+    }
+
+    /**
+     * @brief ヘッダ全体
+     */
+    auto raw_headers() const noexcept -> std::string_view {
+      return m_headers;
+    }
+  };
+
+  /**
+   * @brief パート毎にボディの受信先を決める関数の型
+   * @details 戻り値はそのパートのボディを受け取るbody_receiver（streaming_callbackに変換可能なもの）、voidもしくはnullptrの場合はボディを読み捨てる
+   */
+  template<typename F>
+  concept multipart_handler =
+    std::invocable<F&, const multipart_part&> and
+    (std::same_as<std::invoke_result_t<F&, const multipart_part&>, void> or
+     std::convertible_to<std::invoke_result_t<F&, const multipart_part&>, detail::streaming_callback>);
+
+  /**
+   * @brief multipart（multipart/byteranges、multipart/mixedなど）のレスポンスボディを逐次パースする、body_receiverとして使用する
+   * @tparam F multipart_handler
+   * @details 各パートのヘッダを受信するとhandlerが呼ばれ、その戻り値のreceiverへパートのボディがチャンク毎に渡される
+   * @details パートのボディは受信したチャンクを直接参照して渡され、コピーされない（チャンク境界にかかる区切りの候補の数バイトのみ保持する）
+   * @details 区切りの探索は\rをmemchrで探してから比較する
+   * @details boundaryを指定しない場合、ボディの最初の行から取得する（プリアンブルがある場合はboundaryを指定すること）
+   * @details パートのreceiverがreceive_status::pauseを返した場合、再開後に渡される同じチャンクはそのデータの位置から処理する
+   */
+  template<multipart_handler F>
+  class multipart_parser {
+    enum class state {
+      // 最初の区切りの前
+      preamble,
+      // 区切りの後の行（--なら終端）
+      delimiter_line,
+      // パートのヘッダ
+      headers,
+      // パートのボディ
+      body,
+      // 終端の区切りの後
+      epilogue,
+    };
+
+    F m_handler;
+
+    // "\r\n--boundary"
+    string_t m_delimiter{};
+    state m_state = state::preamble;
+
+    // 行単位で処理する状態における、チャンク境界をまたいだ行
+    string_t m_line{};
+    // 現在のパートのヘッダ
+    string_t m_headers{};
+    // 現在のパートのボディの受信先
+    detail::streaming_callback m_sink{};
+    // チャンク末尾にあった、区切りの先頭と一致する部分
+    string_t m_carry{};
+
+    std::size_t m_part_count = 0;
+    // pauseした場合に、再度渡されるチャンクの処理済みの長さ
+    std::size_t m_resume_offset = 0;
+
+    auto deliver(std::string_view data) -> receive_status {
+      if (data.empty() or not m_sink) {
+        return receive_status::proceed;
+      }
+      return m_sink(std::span<const char>{data.data(), data.size()});
+    }
+
+    void begin_part() {
+      const multipart_part part{m_part_count++, m_headers};
+
+      if constexpr (std::same_as<std::invoke_result_t<F&, const multipart_part&>, void>) {
+        std::invoke(m_handler, part);
+        m_sink = nullptr;
+      } else {
+        m_sink = std::invoke(m_handler, part);
+      }
+    }
+
+    /**
+     * @brief 行単位で処理する状態の1行を処理する
+     */
+    void process_line(std::string_view line) {
+      switch (m_state) {
+        case state::preamble:
+          // 最初の区切りは先頭の改行が省略されうるので、行として処理する
+          if (m_delimiter.size() == 4) {
+            // boundaryの自動検出
+            if (line.starts_with("--") and line.find_first_not_of(" \t", 2) != std::string_view::npos) {
+              m_delimiter.append(line.substr(2, line.find_last_not_of(" \t") - 1));
+              m_state = state::headers;
+              m_headers.clear();
+            }
+          } else if (line.starts_with(std::string_view{m_delimiter}.substr(2))) {
+            const auto rest = line.substr(m_delimiter.size() - 2);
+
+            if (rest.starts_with("--")) {
+              m_state = state::epilogue;
+            } else if (rest.find_first_not_of(" \t") == std::string_view::npos) {
+              m_state = state::headers;
+              m_headers.clear();
+            }
+          }
+          break;
+        case state::delimiter_line:
+          // 区切りの後ろの空白（transport-padding）
+          m_state = state::headers;
+          m_headers.clear();
+          break;
+        case state::headers:
+          if (line.empty()) {
+            begin_part();
+            m_state = state::body;
+          } else {
+            m_headers.append(line).append("\r\n");
+          }
+          break;
+        default:
+          break;
+      }
+    }
+
+    /**
+     * @brief chunk中のpos以降で区切りを探す
+     * @return 区切りの先頭位置、見つからなければnpos
+     */
+    auto find_delimiter(std::string_view chunk, std::size_t pos) const noexcept -> std::size_t {
+      const std::string_view delimiter = m_delimiter;
+
+      while (pos < chunk.size()) {
+        const auto* cr = static_cast<const char*>(std::memchr(chunk.data() + pos, '\r', chunk.size() - pos));
+        if (cr == nullptr) {
+          return std::string_view::npos;
+        }
+
+        const auto cr_pos = static_cast<std::size_t>(cr - chunk.data());
+        const auto rest = chunk.substr(cr_pos, delimiter.size());
+
+        // チャンク末尾で途切れている場合も候補として返す
+        if (delimiter.starts_with(rest)) {
+          return cr_pos;
+        }
+
+        pos = cr_pos + 1;
+      }
+
+      return std::string_view::npos;
+    }
+
+  public:
+
+    /**
+     * @param handler multipart_handler
+     * @param boundary Content-Typeのboundaryパラメータ、空の場合はボディから検出する
+     */
+    explicit multipart_parser(F handler, std::string_view boundary = {})
+      : m_handler(std::forward<F>(handler))
+    {
+      m_delimiter.append("\r\n--").append(boundary);
+    }
+
+    auto operator()(std::span<const char> chunk_span) -> receive_status {
+      const std::string_view chunk{chunk_span.data(), chunk_span.size()};
+      std::size_t pos = std::exchange(m_resume_offset, 0);
+
+      while (pos < chunk.size()) {
+        if (m_state == state::epilogue) {
+          break;
+        }
+
+        if (m_state == state::delimiter_line) {
+          // 終端の区切りは後続の改行を待たずに判定する
+          while (m_line.size() < 2 and pos < chunk.size() and chunk[pos] == '-') {
+            m_line.push_back('-');
+            ++pos;
+          }
+
+          if (m_line == "--") {
+            m_line.clear();
+            m_state = state::epilogue;
+            break;
+          }
+        }
+
+        if (m_state != state::body) {
+          // 行単位で処理する
+          const auto eol_pos = chunk.find('\n', pos);
+          if (eol_pos == std::string_view::npos) {
+            m_line.append(chunk.substr(pos));
+            break;
+          }
+
+          m_line.append(chunk.substr(pos, eol_pos - pos));
+          if (m_line.ends_with('\r')) {
+            m_line.pop_back();
+          }
+
+          process_line(m_line);
+          m_line.clear();
+          pos = eol_pos + 1;
+
+          continue;
+        }
+
+        // 前のチャンクの末尾が区切りの途中だった
+        if (not m_carry.empty()) {
+          const auto rest = std::string_view{m_delimiter}.substr(m_carry.size());
+          const auto head = chunk.substr(pos, rest.size());
+
+          if (rest.starts_with(head)) {
+            if (head.size() < rest.size()) {
+              // まだ判定できない
+              m_carry.append(head);
+              break;
+            }
+
+            // 区切りだった
+            m_carry.clear();
+            m_sink = nullptr;
+            m_state = state::delimiter_line;
+            pos += head.size();
+            continue;
+          }
+
+          // 区切りではなかったので、ボディとして渡す（区切り中の\rは先頭にしかないので、途中から区切りが始まることはない）
+          const auto status = this->deliver(m_carry);
+          if (status == receive_status::abort) {
+            return status;
+          }
+          if (status == receive_status::pause) {
+            m_resume_offset = pos;
+            return status;
+          }
+          m_carry.clear();
+        }
+
+        const auto delim_pos = find_delimiter(chunk, pos);
+        const bool complete = delim_pos != std::string_view::npos and delim_pos + m_delimiter.size() <= chunk.size();
+        const auto body_end = delim_pos == std::string_view::npos ? chunk.size() : delim_pos;
+
+        const auto status = this->deliver(chunk.substr(pos, body_end - pos));
+        if (status == receive_status::abort) {
+          return status;
+        }
+        if (status == receive_status::pause) {
+          m_resume_offset = pos;
+          return status;
+        }
+
+        if (delim_pos == std::string_view::npos) {
+          break;
+        }
+
+        if (complete) {
+          m_sink = nullptr;
+          m_state = state::delimiter_line;
+          pos = delim_pos + m_delimiter.size();
+        } else {
+          // チャンク末尾で途切れた区切りの候補
+          m_carry.assign(chunk.substr(delim_pos));
+          break;
+        }
+      }
+
+      return receive_status::proceed;
+    }
+
+    /**
+     * @brief boundaryを設定する、ボディを受信する前（inspectorの中など）に呼ぶこと
+     */
+    void boundary(std::string_view boundary) {
+      m_delimiter.resize(4);
+      m_delimiter.append(boundary);
+    }
+
+    /**
+     * @brief これまでに開始したパートの数
+     */
+    auto part_count() const noexcept -> std::size_t {
+      return m_part_count;
+    }
+
+    /**
+     * @brief 終端の区切りを受信したか
+     */
+    bool finished() const noexcept {
+      return m_state == state::epilogue;
+    }
+  };
+
+  /**
+   * @brief multipart_parserを作成する
+   * @details 左辺値で渡したハンドラは参照で保持する
+   * @details auto parser = chttpp::parse_multipart(handler, chttpp::multipart_boundary(content_type)); agent.get(path, parser); のように使用する
+   */
+  template<multipart_handler F>
+  auto parse_multipart(F&& handler, std::string_view boundary = {}) -> multipart_parser<F> {
+    return multipart_parser<F>{std::forward<F>(handler), boundary};
+  }
+}
+
+namespace chttpp::inline traits {
+
+  /**
+   * @brief content-typeヘッダの値を自動取得する
+   * @tparam T リクエストボディに指定する型
+   * @details リクエストボディの型から取得する、カスタマイズのためには部分特殊化するか、静的メンバ変数ContentTypeを定義する
+   */
+  template<typename T>
+  inline constexpr std::string_view query_content_type = []{ static_assert([]{return false;}(), "Primary template is ill-formed"); }();
+
+  /**
+   * @brief デフォルト
+   */
+  template<byte_serializable T>
+  inline constexpr std::string_view query_content_type<T> = "application/octet_stream";
+
+  /**
+   * @brief 文字列
+   */
+  template<byte_serializable T>
+    requires detail::string_like<T>
+  inline constexpr std::string_view query_content_type<T> = "text/plain";
+
+  /**
+   * @brief カスタマイズポイント2、静的メンバ変数ContentTypeから取得
+   */
+  template<byte_serializable T>
+    requires requires {
+      { T::ContentType } -> std::convertible_to<std::string_view>;
+    }
+  inline constexpr std::string_view query_content_type<T> = T::ContentType;
+
+  /**
+   * @brief 逐次送信されるリクエストボディ
+   */
+  template<>
+  inline constexpr std::string_view query_content_type<detail::body_reader> = query_content_type<std::span<const char>>;
+
+  /**
+   * @brief multipart/form-data（boundaryパラメータは送信時に付加される）
+   */
+  template<>
+  inline constexpr std::string_view query_content_type<multipart> = "multipart/form-data";
+}
+
+namespace chttpp::detail {
+
+  /**
+   * @brief リクエストボディのソースが実行時に決まるcontent-typeを持つ場合、それを取得する
+   */
+  template<typename Source>
+  auto query_source_content_type(const Source& source) -> std::string_view {
+    if constexpr (requires { { source.content_type() } -> std::convertible_to<std::string_view>; }) {
+      if (std::string_view type = source.content_type(); not type.empty()) {
+        return type;
+      }
+    }
+    return query_content_type<std::span<const char>>;
+  }
+}
+
+#ifndef _MSC_VER
+
+namespace chttpp {
+
+  /**
+   * @brief ファイルの内容をリクエストボディとして送信する
+   * @details 閾値以下のサイズのファイルはmmapして読み出し関数を介さずに送信し、閾値を超えるものはpreadでブロック毎に読み出して送信する
+   * @details Content-Lengthはfstatで取得したサイズを使用し、content-typeは拡張子から推定する
+   * @details ファイルを開けなかった場合、リクエストは例外（std::system_error）を保持したhttp_resultを返す
+   */
+  class file_body {
+    int m_fd = -1;
+    std::size_t m_size = 0;
+    void* m_map = nullptr;
+    std::error_code m_ec{};
+    std::string_view m_content_type{};
+    std::string m_path;
+
+  public:
+
+    // これ以下のサイズのファイルはmmapする
+    static constexpr std::size_t default_mmap_threshold = std::size_t(256) * 1024 * 1024;
+    // preadで読み出す際のブロックサイズ
+    static constexpr std::size_t read_block_size = std::size_t(2) * 1024 * 1024;
+
+    explicit file_body(const std::filesystem::path& path, std::size_t mmap_threshold = default_mmap_threshold)
+      : m_path{path.string()}
+    {
+      if (const auto ext = path.extension().string(); not ext.empty()) {
+        // 先頭の.を除く
+        m_content_type = detail::content_type_from_extension(std::string_view{ext}.substr(1));
+      }
+
+      m_fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+      if (m_fd < 0) {
+        m_ec = std::error_code{errno, std::system_category()};
+        return;
+      }
+
+      struct ::stat st{};
+      if (::fstat(m_fd, &st) != 0) {
+        m_ec = std::error_code{errno, std::system_category()};
+        return;
+      }
+      m_size = static_cast<std::size_t>(st.st_size);
+
+      if (0 < m_size and m_size <= mmap_threshold) {
+        void* addr = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+        if (addr != MAP_FAILED) {
+          // 先頭から順に読まれる
+          ::madvise(addr, m_size, MADV_SEQUENTIAL);
+          m_map = addr;
+        }
+        // mmapに失敗した場合はpreadで読み出す
+      }
+
+      if (m_map == nullptr) {
+        ::posix_fadvise(m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+      }
+    }
+
+    file_body(file_body&& other) noexcept
+      : m_fd{std::exchange(other.m_fd, -1)}
+      , m_size{std::exchange(other.m_size, 0)}
+      , m_map{std::exchange(other.m_map, nullptr)}
+      , m_ec{other.m_ec}
+      , m_content_type{other.m_content_type}
+      , m_path{std::move(other.m_path)}
+    {}
+
+    file_body& operator=(file_body&& other) & noexcept {
+      file_body tmp{std::move(other)};
+      std::swap(m_fd, tmp.m_fd);
+      std::swap(m_size, tmp.m_size);
+      std::swap(m_map, tmp.m_map);
+      std::swap(m_ec, tmp.m_ec);
+      std::swap(m_content_type, tmp.m_content_type);
+      std::swap(m_path, tmp.m_path);
+      return *this;
+    }
+
+    ~file_body() {
+      if (m_map != nullptr) {
+        ::munmap(m_map, m_size);
+      }
+      if (0 <= m_fd) {
+        ::close(m_fd);
+      }
+    }
+
+    explicit operator bool() const noexcept {
+      return not m_ec;
+    }
+
+    auto error() const noexcept -> std::error_code {
+      return m_ec;
+    }
+
+    auto size() const noexcept -> std::size_t {
+      return m_size;
+    }
+
+    bool mapped() const noexcept {
+      return m_map != nullptr;
+    }
+
+    /**
+     * @brief 拡張子から推定されたcontent-type（不明な場合は空）
+     */
+    auto content_type() const noexcept -> std::string_view {
+      return m_content_type;
+    }
+
+    /**
+     * @brief ファイルの内容を読み出すbody_readerを作成する
+     * @details 作成されたbody_readerは*thisを参照するため、*thisはそれより長く生存する必要がある
+     * @exception std::system_error ファイルを開けていない場合
+     */
+    auto as_body_reader() & -> detail::body_reader {
+      if (m_ec) {
+        throw std::system_error{m_ec, m_path};
+      }
+
+      if (m_map != nullptr) {
+        std::span<const char> data{static_cast<const char*>(m_map), m_size};
+
+        // 読み出し関数は使用されないが、念のため用意しておく
+        return detail::body_reader{[rest = data](std::span<char> buffer) mutable -> std::size_t {
+          const std::size_t len = std::min(buffer.size(), rest.size());
+          std::memcpy(buffer.data(), rest.data(), len);
+          rest = rest.subspan(len);
+          return len;
+        }, m_size}.with_contiguous(data);
+      }
+
+      // 読み出し位置は、再送信時のシークと共有する
+      auto offset = std::make_shared<std::size_t>(0);
+
+      return detail::body_reader{[fd = m_fd, size = m_size, offset](std::span<char> buffer) -> std::size_t {
+        const std::size_t len = std::min(buffer.size(), size - *offset);
+        if (len == 0) {
+          return 0;
+        }
+
+        ::ssize_t read_len;
+        do {
+          read_len = ::pread(fd, buffer.data(), len, static_cast<::off_t>(*offset));
+        } while (read_len < 0 and errno == EINTR);
+
+        if (read_len <= 0) {
+          // ファイルが途中で切り詰められた場合など、宣言した長さを送信できない
+          throw std::system_error{read_len < 0 ? errno : EIO, std::system_category()};
+        }
+
+        *offset += static_cast<std::size_t>(read_len);
+        return static_cast<std::size_t>(read_len);
+      }, m_size}.with_block_size(read_block_size).with_seek([size = m_size, offset](std::size_t pos) -> bool {
+        if (size < pos) {
+          return false;
+        }
+        *offset = pos;
+        return true;
+      });
+    }
+  };
+}
+
+#endif
+
+namespace chttpp::detail {
+
+  template<typename MethodTag>
+  struct terse_req_impl {
+
+    using tag_t = MethodTag;
+
+    auto operator()(nt_string_view URL, request_config_for_get cfg = {}) const noexcept -> http_result {
+      return chttpp::underlying::terse::request_impl(URL, std::move(cfg), std::span<const char>{}, MethodTag{});
+    }
+
+    auto operator()(nt_wstring_view URL, request_config_for_get cfg = {}) const noexcept -> http_result {
+      return chttpp::underlying::terse::request_impl(URL, std::move(cfg), std::span<const char>{}, MethodTag{});
+    }
+  };
+
+  template<detail::tag::has_reqbody_method MethodTag>
+  struct terse_req_impl<MethodTag> {
+
+    using tag_t = MethodTag;
+
+    template<byte_serializable Body>
+    auto operator()(nt_string_view URL, Body&& request_body, request_config cfg = {}) const noexcept -> http_result {
+      // なければデフォ値をセット（実行時の状態に基づいて決められた方が良い・・・？
+      if (cfg.content_type.empty()) {
+        cfg.content_type = query_content_type<std::remove_cvref_t<Body>>;
+      }
+      // ここ、request_bodyの完全転送の必要あるかな・・・？
+      return chttpp::underlying::terse::request_impl(URL, std::move(cfg), cpo::as_byte_seq(request_body), MethodTag{});
+    }
+
+    template<byte_serializable Body>
+    auto operator()(nt_wstring_view URL, Body&& request_body, request_config cfg = {}) const noexcept -> http_result {
+      // なければデフォ値をセット（実行時の状態に基づいて決められた方が良い・・・？
+      if (cfg.content_type.empty()) {
+        cfg.content_type = query_content_type<std::remove_cvref_t<Body>>;
+      }
+      return chttpp::underlying::terse::request_impl(URL, std::move(cfg), cpo::as_byte_seq(request_body), MethodTag{});
+    }
+
+#ifndef _MSC_VER
+
+    template<body_source Source>
+      requires (not byte_serializable<Source>)
+    auto operator()(nt_string_view URL, Source&& source, request_config cfg = {}) const noexcept -> http_result try {
+      if (cfg.content_type.empty()) {
+        cfg.content_type = query_source_content_type(source);
+      }
+
+      auto reader = detail::make_body_reader(std::forward<Source>(source));
+      return chttpp::underlying::terse::request_impl(URL, std::move(cfg), reader, MethodTag{});
+    } catch (...) {
+      return http_result{detail::from_exception_ptr};
+    }
+
+    /**
+     * @brief multipart/form-dataのリクエストボディを送信する
+     */
+    auto operator()(nt_string_view URL, multipart& form, request_config cfg = {}) const noexcept -> http_result {
+      if (cfg.content_type.empty()) {
+        cfg.content_type = query_content_type<multipart>;
+      }
+
+      return chttpp::underlying::terse::request_impl(URL, std::move(cfg), form, MethodTag{});
+    }
+
+#endif
+  };
+}
+
+namespace chttpp::inline method_object {
+
+  inline constexpr detail::terse_req_impl<detail::tag::get_t> get{};
+  inline constexpr detail::terse_req_impl<detail::tag::head_t> head{};
+  inline constexpr detail::terse_req_impl<detail::tag::options_t> options{};
+  inline constexpr detail::terse_req_impl<detail::tag::trace_t> trace{};
+
+  inline constexpr detail::terse_req_impl<detail::tag::post_t> post{};
+  inline constexpr detail::terse_req_impl<detail::tag::put_t> put{};
+  inline constexpr detail::terse_req_impl<detail::tag::delete_t> delete_{};
+}
+
+namespace chttpp::detail {
+
+  /**
+   * @brief 標準の符号付き・符号なし整数型（boolと文字型、拡張整数型を含まない）
+   */
+  template<typename T>
+  concept standard_integer =
+    std::same_as<T, signed char> or std::same_as<T, short> or std::same_as<T, int> or std::same_as<T, long> or std::same_as<T, long long> or
+    std::same_as<T, unsigned char> or std::same_as<T, unsigned short> or std::same_as<T, unsigned int> or std::same_as<T, unsigned long> or std::same_as<T, unsigned long long>;
+
+  /**
+   * @brief ルートテンプレートの{}に埋め込める型
+   * @details 文字列はパーセントエンコードされ、整数は10進数で埋め込まれる
+   */
+  template<typename T>
+  concept route_argument = std::convertible_to<const T&, std::string_view> or standard_integer<T>;
+
+  /**
+   * @brief ルートテンプレートを検証し、プレースホルダ（{}）の数を返す
+   * @details 不正なテンプレートはコンパイルエラーになる
+   */
+  consteval auto count_route_placeholders(std::string_view pattern) -> std::size_t {
+    std::size_t count = 0;
+
+    for (std::size_t i = 0; i < pattern.size(); ++i) {
+      const char c = pattern[i];
+
+      if (c == '{') {
+        if (i + 1 == pattern.size() or pattern[i + 1] != '}') {
+          throw "route template : '{' must be followed by '}' (format specifications are not supported)";
+        }
+        ++count;
+        ++i;
+      } else if (c == '}') {
+        throw "route template : unmatched '}'";
+      } else if (c == '#') {
+        throw "route template : fragment is not allowed";
+      } else if (static_cast<unsigned char>(c) <= 0x20 or 0x7F <= static_cast<unsigned char>(c)) {
+        throw "route template : characters that require percent-encoding are not allowed";
+      }
+    }
+
+    return count;
+  }
+
+  /**
+   * @brief ルートテンプレートをプレースホルダで区切った、静的な部分
+   */
+  template<std::size_t N>
+  struct route_segments {
+    std::array<std::string_view, N + 1> segments;
+    // 静的な部分の長さの合計
+    std::size_t static_length;
+  };
+
+  template<fixed_string Pattern>
+  inline constexpr auto route_segments_of = [] {
+    constexpr std::size_t N = count_route_placeholders(Pattern.view());
+
+    route_segments<N> result{};
+    const std::string_view pattern = Pattern.view();
+
+    // count_route_placeholders()で検証済みのため、'{'は必ず"{}"の先頭
+    std::size_t first = 0;
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < pattern.size(); ++i) {
+      if (pattern[i] == '{') {
+        result.segments[n++] = pattern.substr(first, i - first);
+        first = i + 2;
+      }
+    }
+    result.segments[N] = pattern.substr(first);
+    result.static_length = pattern.size() - 2 * N;
+
+    return result;
+  }();
+
+  /**
+   * @brief 引数を束縛したルート
+   * @details 引数は参照で保持するため、リクエストの完了まで生存している必要がある
+   */
+  template<fixed_string Pattern, route_argument... Args>
+  class bound_route {
+    std::tuple<const Args&...> m_args;
+
+    template<typename T>
+    static auto to_view(const T& arg, [[maybe_unused]] std::span<char, 24> buf) noexcept -> std::string_view {
+      if constexpr (std::convertible_to<const T&, std::string_view>) {
+        return arg;
+      } else {
+        // 64bit整数の最大桁数と符号が収まる
+        [[maybe_unused]] const auto [ptr, ec] = std::to_chars(buf.data(), buf.data() + buf.size(), arg);
+        assert(ec == std::errc{});
+        return {buf.data(), ptr};
+      }
+    }
+
+  public:
+
+    constexpr explicit bound_route(const Args&... args) noexcept
+      : m_args(args...)
+    {}
+
+    /**
+     * @brief 引数を埋め込む前のテンプレート文字列
+     * @details パスの値によらず一定のため、メトリクスやログのラベルとして使用できる
+     */
+    static constexpr auto label() noexcept -> std::string_view {
+      return Pattern.view();
+    }
+
+    /**
+     * @brief urlの末尾に、引数を埋め込んだパスを書き込む
+     * @details 必要な長さを先に計算し、確保は1度だけ行う
+     */
+    void write_path(string_t& url) const {
+      constexpr auto& route = route_segments_of<Pattern>;
+      constexpr std::size_t N = sizeof...(Args);
+
+      // 整数の文字列化用
+      [[maybe_unused]] std::array<char, 24 * N> digits;
+      std::array<std::string_view, N> values{};
+
+      [&]<std::size_t... I>(std::index_sequence<I...>) {
+        ((values[I] = to_view(std::get<I>(m_args), std::span<char, 24>{digits.data() + 24 * I, 24})), ...);
+      }(std::index_sequence_for<Args...>{});
+
+      std::size_t length = route.static_length;
+      for (auto v : values) {
+        length += percent_encoded_size(v);
+      }
+
+      const auto old_size = url.size();
+      url.resize(old_size + length);
+
+      char* out = url.data() + old_size;
+      for (std::size_t i = 0; i < N; ++i) {
+        out = std::ranges::copy(route.segments[i], out).out;
+        out = percent_encode_to(out, values[i]);
+      }
+      out = std::ranges::copy(route.segments[N], out).out;
+
+      assert(out == url.data() + url.size());
+    }
+
+    /**
+     * @brief 引数を埋め込んだパスを文字列として取得する
+     */
+    auto str() const -> string_t {
+      string_t path;
+      this->write_path(path);
+      return path;
+    }
+  };
+
+  /**
+   * @brief コンパイル時に検証されるURLのルートテンプレート
+   * @details テンプレート中の{}に、呼び出し時の引数をパーセントエンコードして埋め込む
+   */
+  template<fixed_string Pattern>
+  struct route_template {
+    static constexpr std::size_t arity = count_route_placeholders(Pattern.view());
+
+    // 使用された時点でテンプレートを検証する
+    static_assert(arity == route_segments_of<Pattern>.segments.size() - 1);
+
+    static constexpr auto label() noexcept -> std::string_view {
+      return Pattern.view();
+    }
+
+    template<typename... Args>
+    constexpr auto operator()(const Args&... args) const noexcept -> bound_route<Pattern, Args...> {
+      static_assert(sizeof...(Args) == arity, "The number of arguments does not match the number of placeholders in the route template.");
+      return bound_route<Pattern, Args...>{args...};
+    }
+
+    /**
+     * @brief プレースホルダを持たないルートは、そのままパスとして使用できる
+     */
+    void write_path(string_t& url) const requires (arity == 0) {
+      url.append(Pattern.view());
+    }
+  };
+}
+
+namespace chttpp {
+
+  /**
+   * @brief URLのパスのテンプレート
+   * @details chttpp::route<"/users/{}/repos">(id)のように使用し、agentのリクエスト関数にパスとして渡せる
+   */
+  template<detail::fixed_string Pattern>
+  inline constexpr detail::route_template<Pattern> route{};
+}
+
+namespace chttpp {
+
+  template<typename CharT>
+    requires requires {
+      requires std::is_same_v<CharT, char> or std::is_same_v<CharT, wchar_t>;
+    }
+  class agent {
+    using string = basic_string_t<CharT>;
+    using string_view = std::basic_string_view<CharT>;
+#ifndef _MSC_VER
+    // リクエストのパス（文字列の他、route<...>(args...)も受け付ける）
+    using path_view = std::conditional_t<std::is_same_v<CharT, char>, detail::url_path_ref, string_view>;
+#else
+    using path_view = string_view;
+#endif
+
+    // URLの頭の部分
+    string m_base_url;
+
+    // URLの変換に使用するバッファ（CharTによっては空のクラス）
+    [[no_unique_address]]
+    underlying::agent_impl::determin_buffer_t<CharT> convert_buffer{};
+
+    // session_stateやバッファ等のリソースのまとめ
+    underlying::agent_impl::agent_resource m_resource;
+
+    // 初期化や各種設定中に起きたエラーを記録する
+    detail::error_code m_config_ec;
+
+  // 基本関数群
+  public:
+
+    [[nodiscard]]
+    agent(string_view base_url, detail::agent_initial_config initial_cfg = {})
+      : m_base_url(base_url)
+      , m_resource{ 
+                    .config = std::move(initial_cfg),
+                    .cookie_management = {chttpp::cookie_management::enable},
+                    .follow_redirect = {chttpp::follow_redirects::enable},
+                    .auto_decomp = {chttpp::automatic_decompression::enable},
+                    .request_url{underlying::to_string(m_base_url)}
+                  }
+      , m_config_ec{ m_resource.state.init(base_url, convert_buffer, m_resource.config) }
+    {
+      if (bool(m_config_ec) == false and m_resource.request_url.is_valid() == false) {
+        // 指定されたURLが変であるか、変換エラー
+        m_config_ec = detail::error_code{underlying::lib_error_code_tratis::url_error_value};
+      }
+    }
+
+    agent(const agent&) = delete;
+    agent& operator=(const agent&) = delete;
+
+    agent(agent&&) = default;
+    agent& operator=(agent&&) & = default;
+
+    template<auto Method>
+    auto request(path_view url_path, detail::agent_request_config req_cfg = {}) & noexcept -> detail::http_result {
+      using tag = decltype(Method)::tag_t;
+
+      if (m_config_ec) {
+        return detail::http_result{m_config_ec};
+      }
+
+      return underlying::agent_impl::request_impl(url_path, convert_buffer, m_resource, std::move(req_cfg), std::span<const char>{}, tag{});
+    }
+
+    template<auto Method>
+    auto request(detail::agent_request_config req_cfg = {}) & noexcept -> detail::http_result {
+      return request<Method>("", std::move(req_cfg));
+    }
+
+    template<auto Method, byte_serializable Body>
+      requires detail::tag::has_reqbody_method<typename decltype(Method)::tag_t>
+    auto request(path_view url_path, Body&& request_body, detail::agent_request_config req_cfg = {}) & noexcept -> detail::http_result {
+      using tag = decltype(Method)::tag_t;
+
+      if (m_config_ec) {
+        return detail::http_result{m_config_ec};
+      }
+
+      // なければデフォ値をセット（実行時の状態に基づいて決められた方が良い・・・？
+      // ヘッダで指定してた時はこれどうなるの？？
+      if (req_cfg.content_type.empty()) {
+        req_cfg.content_type = query_content_type<std::remove_cvref_t<Body>>;
+      }
+
+      return underlying::agent_impl::request_impl(url_path, convert_buffer, m_resource, std::move(req_cfg), cpo::as_byte_seq(request_body), tag{});
+    }
+
+    template<auto Method, byte_serializable Body>
+      requires detail::tag::has_reqbody_method<typename decltype(Method)::tag_t> and
+               (not std::is_same_v<Body, detail::agent_request_config>)
+    auto request(Body&& request_body, detail::agent_request_config req_cfg = {}) & noexcept -> detail::http_result {
+      return request<Method>("", std::forward<Body>(request_body), std::move(req_cfg));
+    }
+
+#ifndef _MSC_VER
+
+    /**
+     * @brief リクエストボディを逐次読み出しながら送信する
+     * @details sourceはチャンクの範囲（std::generatorなど）、読み出し関数、もしくはstream_body()の戻り値
+     */
+    template<auto Method, body_source Source>
+      requires detail::tag::has_reqbody_method<typename decltype(Method)::tag_t> and
+               (not byte_serializable<Source>)
+    auto request(path_view url_path, Source&& source, detail::agent_request_config req_cfg = {}) & noexcept -> detail::http_result try {
+      using tag = decltype(Method)::tag_t;
+
+      if (m_config_ec) {
+        return detail::http_result{m_config_ec};
+      }
+
+      if (req_cfg.content_type.empty()) {
+        req_cfg.content_type = detail::query_source_content_type(source);
+      }
+
+      auto reader = detail::make_body_reader(std::forward<Source>(source));
+      return underlying::agent_impl::request_impl(url_path, convert_buffer, m_resource, std::move(req_cfg), reader, tag{});
+    } catch (...) {
+      return detail::http_result{detail::from_exception_ptr};
+    }
+
+    /**
+     * @brief multipart/form-dataのリクエストボディを送信する
+     */
+    template<auto Method>
+      requires detail::tag::has_reqbody_method<typename decltype(Method)::tag_t>
+    auto request(path_view url_path, multipart& form, detail::agent_request_config req_cfg = {}) & noexcept -> detail::http_result {
+      using tag = decltype(Method)::tag_t;
+
+      if (m_config_ec) {
+        return detail::http_result{m_config_ec};
+      }
+
+      if (req_cfg.content_type.empty()) {
+        req_cfg.content_type = query_content_type<multipart>;
+      }
+
+      return underlying::agent_impl::request_impl(url_path, convert_buffer, m_resource, std::move(req_cfg), form, tag{});
+    }
+
+#endif
+
+    /**
+     * @brief レスポンスボディを、指定された関数オブジェクトで直接受け取る
+     * @details receiverはチャンク毎にstd::span<const char>で呼ばれ、receive_status::abortを返すと転送を中断する
+     * @details streaming_receiverと異なり型消去を介さないため、呼び出しはインライン化されうる
+     */
+    template<auto Method, detail::body_receiver Receiver>
+      requires (not detail::tag::has_reqbody_method<typename decltype(Method)::tag_t>)
+    auto request(path_view url_path, Receiver&& receiver, detail::agent_request_config req_cfg = {}) & noexcept -> detail::http_result {
+      using tag = decltype(Method)::tag_t;
+
+      if (m_config_ec) {
+        return detail::http_result{m_config_ec};
+      }
+
+      return underlying::agent_impl::request_impl(url_path, convert_buffer, m_resource, std::move(req_cfg), std::span<const char>{}, tag{}, receiver);
+    }
+
+    template<auto Method, byte_serializable Body, detail::body_receiver Receiver>
+      requires detail::tag::has_reqbody_method<typename decltype(Method)::tag_t>
+    auto request(path_view url_path, Body&& request_body, Receiver&& receiver, detail::agent_request_config req_cfg = {}) & noexcept -> detail::http_result {
+      using tag = decltype(Method)::tag_t;
+
+      if (m_config_ec) {
+        return detail::http_result{m_config_ec};
+      }
+
+      if (req_cfg.content_type.empty()) {
+        req_cfg.content_type = query_content_type<std::remove_cvref_t<Body>>;
+      }
+
+      return underlying::agent_impl::request_impl(url_path, convert_buffer, m_resource, std::move(req_cfg), cpo::as_byte_seq(request_body), tag{}, receiver);
+    }
+
+    auto get(path_view url_path, detail::agent_request_config req_cfg = {}) & noexcept -> detail::http_result {
+      return this->request<::chttpp::get>(url_path, std::move(req_cfg));
+    }
+
+    auto get(path_view url_path, detail::body_receiver auto&& receiver, detail::agent_request_config req_cfg = {}) & noexcept -> detail::http_result {
+      return this->request<::chttpp::get>(url_path, receiver, std::move(req_cfg));
+    }
+
+    auto get(detail::agent_request_config req_cfg = {}) & noexcept -> detail::http_result {
+      return this->request<::chttpp::get>("", std::move(req_cfg));
+    }
+
+#ifndef _MSC_VER
+
+    /**
+     * @brief text/event-streamを購読し、受信したイベント毎にhandlerを呼び出す
+     * @details 接続が切れると、サーバーの指定する（なければsse_config::retryの）時間だけ待ってから、Last-Event-IDを付けて再接続する
+     * @details handlerがreceive_status::abortを返すか、ステータスが200以外、もしくはContent-Typeがtext/event-streamではない場合に終了する
+     * @details 転送全体のタイムアウトの代わりに、sse_config::idle_timeoutの間受信がない場合にタイムアウトとし、再接続する
+     * @return 最後の接続の結果
+     */
+    template<sse_handler F>
+    auto event_stream(path_view url_path, F&& handler, detail::sse_config sse_cfg = {}) & noexcept -> detail::http_result try {
+      // ハンドラによって中断された
+      bool stopped = false;
+      // 購読を継続できないレスポンスを受け取った
+      bool rejected = false;
+      // 現在の接続でイベントを受け取った
+      bool received = false;
+
+      auto parser = parse_sse([&received, &handler](const sse_event& event) -> receive_status {
+        received = true;
+
+        if constexpr (std::same_as<std::invoke_result_t<F&, const sse_event&>, void>) {
+          std::invoke(handler, event);
+          return receive_status::proceed;
+        } else {
+          return std::invoke(handler, event);
+        }
+      });
+      parser.last_event_id(sse_cfg.last_event_id);
+
+      auto receiver = [&](std::span<const char> chunk) -> receive_status {
+        if (rejected) {
+          // ボディはイベントとして扱わない
+          return receive_status::proceed;
+        }
+
+        const auto status = parser(chunk);
+        stopped = status == receive_status::abort;
+
+        return status;
+      };
+
+      auto inspector = [&rejected](const detail::response_head& head) -> detail::body_action {
+        rejected = head.status != 200 or not head.content_type.starts_with("text/event-stream");
+        return detail::body_action::keep();
+      };
+
+      // イベントを受け取れずに再接続した回数
+      unsigned int retry_count = 0;
+
+      while (true) {
+        parser.reset();
+        rejected = false;
+        received = false;
+
+        const string_t last_id{parser.last_event_id()};
+
+        auto result = last_id.empty()
+          ? this->get(url_path, receiver, { .headers = { {"Accept", "text/event-stream"}, {"Cache-Control", "no-cache"} }, .inspector = inspector, .idle_timeout = sse_cfg.idle_timeout })
+          : this->get(url_path, receiver, { .headers = { {"Accept", "text/event-stream"}, {"Cache-Control", "no-cache"}, {"Last-Event-ID", last_id} }, .inspector = inspector, .idle_timeout = sse_cfg.idle_timeout });
+
+        if (stopped) {
+          return result;
+        }
+
+        // 200以外（204を含む）のレスポンスを受け取った場合は再接続しない
+        if (result and (result.status_code().value() != 200 or rejected)) {
+          return result;
+        }
+
+        if (received) {
+          retry_count = 0;
+        } else if (sse_cfg.max_retry <= retry_count++) {
+          return result;
+        }
+
+        std::this_thread::sleep_for(parser.retry().value_or(sse_cfg.retry));
+      }
+    } catch (...) {
+      return detail::http_result{detail::from_exception_ptr};
+    }
+
+    /**
+     * @brief レスポンスボディを、チャンク毎に読み進めるストリームとしてリクエストする
+     * @details レスポンスヘッダを受信した時点で返る。ボディの転送は、body()のイテレータを進めるのに応じて進行する
+     * @details ストリームはagentのセッションを複製して転送するため、ストリームを開いたままagentで他のリクエストを行える
+     */
+    template<auto Method = ::chttpp::get>
+      requires (not detail::tag::has_reqbody_method<typename decltype(Method)::tag_t>)
+    auto open_stream(path_view url_path, detail::agent_request_config req_cfg = {}) & -> underlying::agent_impl::response_stream {
+      using tag = decltype(Method)::tag_t;
+
+      if (m_config_ec) {
+        return underlying::agent_impl::response_stream{m_config_ec.value()};
+      }
+
+      return underlying::agent_impl::open_stream_impl(url_path, convert_buffer, m_resource, std::move(req_cfg), std::span<const char>{}, tag{});
+    }
+
+    /**
+     * @brief レスポンスボディを、メモリに保持せずに直接ファイルへ書き込む
+     * @details 既存のファイルがある場合、Range（とIf-Range）によってその続きから要求する。転送が途中で切断された場合も同様に続きから再試行する
+     * @details 既存のファイルが既に完全である（416のContent-Rangeが示す全体の長さと一致する）場合は、ステータスコードを200として返す
+     * @details 戻り値のhttp_responseのボディは空となる。ファイル操作のエラーは例外（std::system_error）として返される
+     */
+    auto download(path_view url_path, const std::filesystem::path& file_path, detail::download_config dl_cfg = {}, detail::agent_request_config req_cfg = {}) & noexcept -> detail::http_result {
+      if (m_config_ec) {
+        return detail::http_result{m_config_ec};
+      }
+
+      return underlying::agent_impl::download_impl(url_path, convert_buffer, m_resource, std::move(req_cfg), file_path, dl_cfg, detail::tag::get_t{});
+    }
+
+    /**
+     * @brief 追記されていくリソースについて、前回の呼び出し以降に追加された部分のみを取得する
+     * @details パスとURLパラメータ（req_cfg.params）の組毎に取得済みの長さとETag（またはLast-Modified）を記録し、Range（とIf-Range）によってその続きを要求する
+     * @details 206の場合は追加された部分、200の場合は（初回か、リソースが置き換えられたため）全体がボディとなる
+     * @details 416の場合は追加がなく、ボディは空となる
+     */
+    auto tail(path_view url_path, detail::agent_request_config req_cfg = {}) & noexcept -> detail::http_result {
+      if (m_config_ec) {
+        return detail::http_result{m_config_ec};
+      }
+
+      return underlying::agent_impl::tail_impl(url_path, convert_buffer, m_resource, std::move(req_cfg));
+    }
+
+    /**
+     * @brief tail()で記録しているリソースの状態を破棄し、次回は最初から取得するようにする
+     * @details tail()に渡したものと同じパスとURLパラメータを指定する
+     */
+    void reset_tail(path_view url_path, detail::agent_request_config req_cfg = {}) & {
+      underlying::agent_impl::reset_tail(url_path, convert_buffer, m_resource, req_cfg);
+    }
+
+    /**
+     * @brief 1つのリソースを複数の範囲に分割し、それぞれを別の接続で並行してダウンロードする
+     * @details HEADでサイズを取得し、範囲リクエストに対応していない場合は1つの接続でダウンロードする
+     * @details 各部分の転送はagentのセッションを複製して行うため、agentに設定されたヘッダや認証情報はそのまま使用される
+     * @details 戻り値のhttp_responseはHEADに対するレスポンスで、ボディは空となる
+     */
+    auto parallel_download(path_view url_path, const std::filesystem::path& file_path, detail::parallel_download_config pd_cfg = {}, detail::agent_request_config req_cfg = {}) & noexcept -> detail::http_result {
+      if (m_config_ec) {
+        return detail::http_result{m_config_ec};
+      }
+
+      return underlying::agent_impl::parallel_download_impl(url_path, convert_buffer, m_resource, std::move(req_cfg), file_path, pd_cfg);
+    }
+
+#endif
+
+    auto post(path_view url_path, byte_serializable auto&& request_body, detail::agent_request_config req_cfg = {}) & noexcept -> detail::http_result {
+      return this->request<::chttpp::post>(url_path, request_body, std::move(req_cfg));
+    }
+
+#ifndef _MSC_VER
+
+    template<body_source Source>
+      requires (not byte_serializable<Source>)
+    auto post(path_view url_path, Source&& source, detail::agent_request_config req_cfg = {}) & noexcept -> detail::http_result {
+      return this->request<::chttpp::post>(url_path, std::forward<Source>(source), std::move(req_cfg));
+    }
+
+    auto post(path_view url_path, multipart& form, detail::agent_request_config req_cfg = {}) & noexcept -> detail::http_result {
+      return this->request<::chttpp::post>(url_path, form, std::move(req_cfg));
+    }
+
+#endif
 
     template<byte_serializable Body>
       requires (not std::is_same_v<Body, detail::agent_request_config>)
@@ -610,8 +3084,266 @@ namespace chttpp {
   };
 
   template<typename... Args>
-  agent(std::string_view, detail::request_config = {}, Args&&...) -> agent<char>;
+  agent(std::string_view, detail::agent_initial_config = {}, Args&&...) -> agent<char>;
 
   template<typename... Args>
-  agent(std::wstring_view, detail::request_config = {}, Args&&...) -> agent<wchar_t>;
+  agent(std::wstring_view, detail::agent_initial_config = {}, Args&&...) -> agent<wchar_t>;
+
+  /**
+   * @brief agentを介して、リモートのリソースの任意の位置をRangeリクエストによって読み出す
+   * @details 読み出しは固定長のブロック単位で行われ、取得したブロックはLRUキャッシュに保持される
+   * @details 連続した位置の読み込みを検出した場合、後続のブロックを同じリクエストで先読みする
+   * @details agentの接続を再利用するため、agentはこのオブジェクトよりも長く生存している必要がある
+   */
+  template<typename CharT>
+  class remote_file {
+    using string = basic_string_t<CharT>;
+    using string_view = std::basic_string_view<CharT>;
+
+    agent<CharT>* m_agent;
+    string m_path;
+    detail::remote_file_config m_config;
+    detail::block_cache m_cache;
+
+    // リソース全体の長さ（不明な間はunknown_length）
+    std::uint64_t m_size = detail::content_range::unknown_length;
+    // 読み出し中のリソースが変更されていないことを確認する（強いETagのみ）
+    string_t m_etag{};
+    // 直前の読み込みの終端、連続した読み込みの検出に使用する
+    std::uint64_t m_next_offset = 0;
+
+    detail::error_code m_ec{};
+    std::uint16_t m_status = 0;
+
+    /**
+     * @brief [first_block, last_block]のブロックを1つのリクエストで取得し、キャッシュする
+     */
+    bool fetch(std::uint64_t first_block, std::uint64_t last_block) {
+      const std::uint64_t block_size = m_config.block_size;
+      const std::uint64_t first = first_block * block_size;
+      std::uint64_t last = (last_block + 1) * block_size - 1;
+
+      if (m_size != detail::content_range::unknown_length) {
+        last = std::min(last, m_size - 1);
+      }
+
+      const std::uint64_t range_len = last - first + 1;
+
+      char range_buf[64] = "bytes=";
+      {
+        auto* ptr = std::to_chars(range_buf + 6, std::ranges::end(range_buf), first).ptr;
+        *ptr++ = '-';
+        ptr = std::to_chars(ptr, std::ranges::end(range_buf), last).ptr;
+        *ptr = '\0';
+      }
+      const std::string_view range{range_buf};
+
+      vector_t<char> received;
+      received.reserve(static_cast<std::size_t>(range_len));
+      bool overflow = false;
+
+      auto receiver = [&](std::span<const char> data) -> receive_status {
+        if (range_len < received.size() + data.size()) {
+          // Rangeが無視され、全体が送られてきている
+          overflow = true;
+          return receive_status::abort;
+        }
+
+        received.insert(received.end(), data.begin(), data.end());
+        return receive_status::proceed;
+      };
+
+      auto res = m_etag.empty() ? m_agent->get(m_path, receiver, { .headers = { {"Range", range} }, .identity_encoding = true })
+                                : m_agent->get(m_path, receiver, { .headers = { {"Range", range}, {"If-Match", m_etag} }, .identity_encoding = true });
+
+      if (overflow) {
+        m_ec = detail::error_code{underlying::lib_error_code_tratis::range_error_value};
+        return false;
+      }
+      if (not res) {
+        m_ec = res.error();
+        return false;
+      }
+
+      m_status = res.status_code().value();
+      const auto content_range = detail::parse_content_range(res.response_header("content-range"));
+
+      if (m_status == 416) {
+        // 範囲がリソースの外にある
+        if (content_range) {
+          m_size = content_range->length;
+        }
+        return true;
+      }
+
+      if (m_status == 206) {
+        if (not content_range or not content_range->has_range or content_range->first != first) {
+          m_ec = detail::error_code{underlying::lib_error_code_tratis::range_error_value};
+          return false;
+        }
+        m_size = content_range->length;
+      } else if (m_status == 200 and first == 0) {
+        // 全体が範囲に収まっている
+        m_size = received.size();
+      } else {
+        // 412（リソースが変更された）など
+        m_ec = detail::error_code{underlying::lib_error_code_tratis::range_error_value};
+        return false;
+      }
+
+      if (m_etag.empty()) {
+        if (const auto etag = res.response_header("etag"); not etag.empty() and not etag.starts_with("W/")) {
+          m_etag = etag;
+        }
+      }
+
+      const std::span<const char> data{received};
+      for (std::uint64_t offset = 0; offset < data.size(); offset += block_size) {
+        m_cache.insert(first_block + offset / block_size, data.subspan(static_cast<std::size_t>(offset), static_cast<std::size_t>(std::min<std::uint64_t>(block_size, data.size() - offset))));
+      }
+
+      return true;
+    }
+
+  public:
+
+    remote_file(agent<CharT>& agent_ref, string_view path, detail::remote_file_config cfg = {})
+      : m_agent{std::addressof(agent_ref)}
+      , m_path(path)
+      , m_config{cfg}
+      , m_cache{cfg.cache_blocks}
+    {
+      m_config.block_size = std::max<std::size_t>(m_config.block_size, 1);
+    }
+
+    /**
+     * @brief 指定位置から、バッファを満たすまで読み出す
+     * @return 読み出した長さ、リソースの終端に達するかエラーが起きた場合はバッファの長さより短くなる
+     */
+    auto read(std::uint64_t offset, std::span<char> buffer) -> std::size_t {
+      m_ec = detail::error_code{};
+
+      const std::uint64_t block_size = m_config.block_size;
+      const bool sequential = offset != 0 and offset == m_next_offset;
+      std::size_t done = 0;
+
+      while (done < buffer.size()) {
+        const std::uint64_t pos = offset + done;
+        if (m_size != detail::content_range::unknown_length and m_size <= pos) {
+          break;
+        }
+
+        const std::uint64_t index = pos / block_size;
+        const auto* block = m_cache.find(index);
+
+        if (block == nullptr) {
+          // 読み込み範囲の残りと先読み分を、キャッシュに収まる範囲でまとめて取得する
+          std::uint64_t last_block = (offset + buffer.size() - 1) / block_size + (sequential ? m_config.readahead_blocks : 0);
+          last_block = std::min<std::uint64_t>(last_block, index + m_cache.capacity() - 1);
+
+          if (m_size != detail::content_range::unknown_length) {
+            last_block = std::min(last_block, (m_size - 1) / block_size);
+          }
+
+          if (not this->fetch(index, last_block)) {
+            break;
+          }
+
+          block = m_cache.find(index);
+          if (block == nullptr) {
+            break;
+          }
+        }
+
+        const std::uint64_t in_block = pos - index * block_size;
+        if (block->size() <= in_block) {
+          break;
+        }
+
+        const std::size_t len = static_cast<std::size_t>(std::min<std::uint64_t>(block->size() - in_block, buffer.size() - done));
+        std::ranges::copy_n(block->data() + in_block, len, buffer.data() + done);
+        done += len;
+
+        if (block->size() < block_size and in_block + len == block->size()) {
+          // 短いブロックはリソースの最後のブロック
+          break;
+        }
+      }
+
+      m_next_offset = offset + done;
+
+      return done;
+    }
+
+    /**
+     * @brief 指定位置から、最大len文字を読み出す
+     */
+    auto read(std::uint64_t offset, std::size_t len) -> vector_t<char> {
+      vector_t<char> buffer(len);
+      buffer.resize(this->read(offset, std::span<char>{buffer}));
+      return buffer;
+    }
+
+    /**
+     * @brief リソース全体の長さを取得する
+     * @details 不明な場合は先頭のブロックを取得して調べる、取得できない場合は0を返す
+     */
+    auto size() -> std::uint64_t {
+      if (m_size == detail::content_range::unknown_length) {
+        m_ec = detail::error_code{};
+        if (not this->fetch(0, 0) or m_size == detail::content_range::unknown_length) {
+          return 0;
+        }
+      }
+
+      return m_size;
+    }
+
+    /**
+     * @brief 直前の操作がエラーなく完了したか
+     */
+    explicit operator bool() const noexcept {
+      return not bool(m_ec);
+    }
+
+    auto error() const -> detail::error_code {
+      return m_ec;
+    }
+
+    /**
+     * @brief 直前のRangeリクエストのレスポンスのステータスコード
+     */
+    auto status_code() const -> detail::http_status_code {
+      return detail::http_status_code{m_status};
+    }
+
+    auto cached_blocks() const noexcept -> std::size_t {
+      return m_cache.size();
+    }
+  };
+
+  template<typename CharT>
+  remote_file(agent<CharT>&, std::type_identity_t<std::basic_string_view<CharT>>, detail::remote_file_config = {}) -> remote_file<CharT>;
+
+#ifndef _MSC_VER
+
+  /**
+   * @brief URLの示すリソースを、複数の接続で並行してファイルへダウンロードする
+   * @details agentを使用しない場合の簡易版
+   */
+  inline auto parallel_download(std::string_view url, const std::filesystem::path& file_path, detail::parallel_download_config pd_cfg = {}, detail::agent_initial_config initial_cfg = {}) noexcept -> detail::http_result try {
+    auto req = agent<char>{url, std::move(initial_cfg)};
+    return req.parallel_download("", file_path, pd_cfg);
+  } catch (...) {
+    return detail::http_result{detail::from_exception_ptr};
+  }
+
+  inline auto parallel_download(std::wstring_view url, const std::filesystem::path& file_path, detail::parallel_download_config pd_cfg = {}, detail::agent_initial_config initial_cfg = {}) noexcept -> detail::http_result try {
+    auto req = agent<wchar_t>{url, std::move(initial_cfg)};
+    return req.parallel_download(L"", file_path, pd_cfg);
+  } catch (...) {
+    return detail::http_result{detail::from_exception_ptr};
+  }
+
+#endif
 }
\ No newline at end of file
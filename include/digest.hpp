@@ -0,0 +1,405 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+#include <array>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace chttpp::digest::detail {
+
+  constexpr auto rotr(std::uint32_t x, int n) noexcept -> std::uint32_t {
+    return (x >> n) | (x << (32 - n));
+  }
+
+  constexpr auto rotl(std::uint32_t x, int n) noexcept -> std::uint32_t {
+    return (x << n) | (x >> (32 - n));
+  }
+
+  /**
+   * @brief 64バイトブロック単位で処理するハッシュ関数の、ブロック分割と末尾処理の共通部分
+   * @tparam Derived process_block(const unsigned char*)とstore_length(unsigned char*, std::uint64_t)を持つ型
+   */
+  template<typename Derived>
+  class block_hasher {
+    unsigned char m_block[64]{};
+    std::size_t m_block_len = 0;
+    std::uint64_t m_total_len = 0;
+
+    auto self() noexcept -> Derived& {
+      return static_cast<Derived&>(*this);
+    }
+
+  public:
+
+    void update(std::span<const char> data) noexcept {
+      auto* ptr = reinterpret_cast<const unsigned char*>(data.data());
+      std::size_t len = data.size();
+
+      m_total_len += len;
+
+      // 前回の端数があれば、まずブロックを埋める
+      if (m_block_len != 0) {
+        const std::size_t fill_len = std::min(sizeof(m_block) - m_block_len, len);
+        std::memcpy(m_block + m_block_len, ptr, fill_len);
+
+        m_block_len += fill_len;
+        ptr += fill_len;
+        len -= fill_len;
+
+        if (m_block_len < sizeof(m_block)) {
+          return;
+        }
+
+        self().process_block(m_block);
+        m_block_len = 0;
+      }
+
+      // 完全なブロックはコピーせずに処理する
+      for (; sizeof(m_block) <= len; ptr += sizeof(m_block), len -= sizeof(m_block)) {
+        self().process_block(ptr);
+      }
+
+      std::memcpy(m_block, ptr, len);
+      m_block_len = len;
+    }
+
+  protected:
+
+    /**
+     * @brief パディングと長さを付加して最後のブロックを処理する
+     * @details 状態を変更するため、コピーに対して呼び出す
+     */
+    void finalize() noexcept {
+      const std::uint64_t bit_len = m_total_len * 8;
+
+      m_block[m_block_len++] = 0x80;
+
+      if (sizeof(m_block) - 8 < m_block_len) {
+        std::memset(m_block + m_block_len, 0, sizeof(m_block) - m_block_len);
+        self().process_block(m_block);
+        m_block_len = 0;
+      }
+
+      std::memset(m_block + m_block_len, 0, sizeof(m_block) - 8 - m_block_len);
+      Derived::store_length(m_block + sizeof(m_block) - 8, bit_len);
+      self().process_block(m_block);
+    }
+  };
+
+  /**
+   * @brief 反転多項式によるCRC-32の、スライスバイ8用のテーブル
+   */
+  template<std::uint32_t Polynomial>
+  inline constexpr auto crc32_table = [] {
+    std::array<std::array<std::uint32_t, 256>, 8> table{};
+
+    for (std::uint32_t i = 0; i < 256; ++i) {
+      std::uint32_t crc = i;
+      for (int k = 0; k < 8; ++k) {
+        crc = (crc & 1) ? (crc >> 1) ^ Polynomial : (crc >> 1);
+      }
+      table[0][i] = crc;
+    }
+
+    for (std::size_t t = 1; t < 8; ++t) {
+      for (std::size_t i = 0; i < 256; ++i) {
+        table[t][i] = (table[t - 1][i] >> 8) ^ table[0][table[t - 1][i] & 0xff];
+      }
+    }
+
+    return table;
+  }();
+
+  /**
+   * @brief CRC-32系チェックサムの共通実装
+   * @details 1度に8バイトずつテーブルを引く（slicing-by-8）
+   */
+  template<std::uint32_t Polynomial>
+  class crc32_base {
+    std::uint32_t m_crc = 0xffffffff;
+
+  public:
+
+    static constexpr std::size_t digest_size = 4;
+    using result_type = std::array<unsigned char, digest_size>;
+
+    void update(std::span<const char> data) noexcept {
+      constexpr auto& table = crc32_table<Polynomial>;
+
+      auto* ptr = reinterpret_cast<const unsigned char*>(data.data());
+      std::size_t len = data.size();
+      std::uint32_t crc = m_crc;
+
+      for (; 8 <= len; ptr += 8, len -= 8) {
+        const std::uint32_t lo = crc ^ (std::uint32_t(ptr[0]) | std::uint32_t(ptr[1]) << 8 | std::uint32_t(ptr[2]) << 16 | std::uint32_t(ptr[3]) << 24);
+        const std::uint32_t hi = std::uint32_t(ptr[4]) | std::uint32_t(ptr[5]) << 8 | std::uint32_t(ptr[6]) << 16 | std::uint32_t(ptr[7]) << 24;
+
+        crc = table[7][lo & 0xff] ^ table[6][(lo >> 8) & 0xff] ^ table[5][(lo >> 16) & 0xff] ^ table[4][lo >> 24] ^
+              table[3][hi & 0xff] ^ table[2][(hi >> 8) & 0xff] ^ table[1][(hi >> 16) & 0xff] ^ table[0][hi >> 24];
+      }
+
+      for (; len != 0; ++ptr, --len) {
+        crc = (crc >> 8) ^ table[0][(crc ^ *ptr) & 0xff];
+      }
+
+      m_crc = crc;
+    }
+
+    /**
+     * @brief ここまでに入力されたデータのチェックサム
+     */
+    auto checksum() const noexcept -> std::uint32_t {
+      return m_crc ^ 0xffffffff;
+    }
+
+    /**
+     * @brief チェックサムをビッグエンディアンのバイト列として取得する
+     */
+    auto value() const noexcept -> result_type {
+      const auto crc = checksum();
+      return { static_cast<unsigned char>(crc >> 24), static_cast<unsigned char>(crc >> 16), static_cast<unsigned char>(crc >> 8), static_cast<unsigned char>(crc) };
+    }
+  };
+}
+
+namespace chttpp::digest {
+
+  /**
+   * @brief SHA-256
+   * @details update()でデータを逐次入力し、value()でそこまでのハッシュ値を得る
+   */
+  class sha256 : public detail::block_hasher<sha256> {
+    friend class detail::block_hasher<sha256>;
+
+    std::uint32_t m_state[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+
+    void process_block(const unsigned char* block) noexcept {
+      static constexpr std::uint32_t k[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+      };
+
+      std::uint32_t w[64];
+      for (int i = 0; i < 16; ++i) {
+        w[i] = std::uint32_t(block[i * 4]) << 24 | std::uint32_t(block[i * 4 + 1]) << 16 | std::uint32_t(block[i * 4 + 2]) << 8 | std::uint32_t(block[i * 4 + 3]);
+      }
+      for (int i = 16; i < 64; ++i) {
+        const auto s0 = detail::rotr(w[i - 15], 7) ^ detail::rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        const auto s1 = detail::rotr(w[i - 2], 17) ^ detail::rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+      }
+
+      auto [a, b, c, d, e, f, g, h] = m_state;
+
+      for (int i = 0; i < 64; ++i) {
+        const auto t1 = h + (detail::rotr(e, 6) ^ detail::rotr(e, 11) ^ detail::rotr(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+        const auto t2 = (detail::rotr(a, 2) ^ detail::rotr(a, 13) ^ detail::rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+      }
+
+      m_state[0] += a;
+      m_state[1] += b;
+      m_state[2] += c;
+      m_state[3] += d;
+      m_state[4] += e;
+      m_state[5] += f;
+      m_state[6] += g;
+      m_state[7] += h;
+    }
+
+    static void store_length(unsigned char* dst, std::uint64_t bit_len) noexcept {
+      for (int i = 0; i < 8; ++i) {
+        dst[i] = static_cast<unsigned char>(bit_len >> (56 - i * 8));
+      }
+    }
+
+  public:
+
+    static constexpr std::size_t digest_size = 32;
+    using result_type = std::array<unsigned char, digest_size>;
+
+    /**
+     * @brief ここまでに入力されたデータのハッシュ値
+     */
+    auto value() const noexcept -> result_type {
+      auto copy = *this;
+      copy.finalize();
+
+      result_type result;
+      for (std::size_t i = 0; i < 8; ++i) {
+        result[i * 4]     = static_cast<unsigned char>(copy.m_state[i] >> 24);
+        result[i * 4 + 1] = static_cast<unsigned char>(copy.m_state[i] >> 16);
+        result[i * 4 + 2] = static_cast<unsigned char>(copy.m_state[i] >> 8);
+        result[i * 4 + 3] = static_cast<unsigned char>(copy.m_state[i]);
+      }
+      return result;
+    }
+  };
+
+  /**
+   * @brief MD5
+   * @details Content-MD5ヘッダの検証など、互換性のためだけに使用すること
+   */
+  class md5 : public detail::block_hasher<md5> {
+    friend class detail::block_hasher<md5>;
+
+    std::uint32_t m_state[4] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
+
+    void process_block(const unsigned char* block) noexcept {
+      static constexpr std::uint32_t k[64] = {
+        0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+        0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+        0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+        0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+        0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+        0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+        0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+        0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+      };
+      static constexpr int s[64] = {
+        7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+        5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20,
+        4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+        6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21,
+      };
+
+      std::uint32_t m[16];
+      for (int i = 0; i < 16; ++i) {
+        m[i] = std::uint32_t(block[i * 4]) | std::uint32_t(block[i * 4 + 1]) << 8 | std::uint32_t(block[i * 4 + 2]) << 16 | std::uint32_t(block[i * 4 + 3]) << 24;
+      }
+
+      auto [a, b, c, d] = m_state;
+
+      for (int i = 0; i < 64; ++i) {
+        std::uint32_t f;
+        int g;
+
+        if (i < 16) {
+          f = (b & c) | (~b & d);
+          g = i;
+        } else if (i < 32) {
+          f = (d & b) | (~d & c);
+          g = (5 * i + 1) % 16;
+        } else if (i < 48) {
+          f = b ^ c ^ d;
+          g = (3 * i + 5) % 16;
+        } else {
+          f = c ^ (b | ~d);
+          g = (7 * i) % 16;
+        }
+
+        const auto tmp = d;
+        d = c;
+        c = b;
+        b = b + detail::rotl(a + f + k[i] + m[g], s[i]);
+        a = tmp;
+      }
+
+      m_state[0] += a;
+      m_state[1] += b;
+      m_state[2] += c;
+      m_state[3] += d;
+    }
+
+    static void store_length(unsigned char* dst, std::uint64_t bit_len) noexcept {
+      for (int i = 0; i < 8; ++i) {
+        dst[i] = static_cast<unsigned char>(bit_len >> (i * 8));
+      }
+    }
+
+  public:
+
+    static constexpr std::size_t digest_size = 16;
+    using result_type = std::array<unsigned char, digest_size>;
+
+    /**
+     * @brief ここまでに入力されたデータのハッシュ値
+     */
+    auto value() const noexcept -> result_type {
+      auto copy = *this;
+      copy.finalize();
+
+      result_type result;
+      for (std::size_t i = 0; i < 4; ++i) {
+        result[i * 4]     = static_cast<unsigned char>(copy.m_state[i]);
+        result[i * 4 + 1] = static_cast<unsigned char>(copy.m_state[i] >> 8);
+        result[i * 4 + 2] = static_cast<unsigned char>(copy.m_state[i] >> 16);
+        result[i * 4 + 3] = static_cast<unsigned char>(copy.m_state[i] >> 24);
+      }
+      return result;
+    }
+  };
+
+  /**
+   * @brief CRC-32（IEEE 802.3、zipやgzipと同じもの）
+   */
+  using crc32 = detail::crc32_base<0xedb88320>;
+
+  /**
+   * @brief CRC-32C（Castagnoli）
+   */
+  using crc32c = detail::crc32_base<0x82f63b78>;
+
+  /**
+   * @brief バイト列をbase64（パディングあり）で符号化する
+   */
+  inline auto to_base64(std::span<const unsigned char> bytes) -> std::string {
+    static constexpr char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    std::string result;
+    result.reserve((bytes.size() + 2) / 3 * 4);
+
+    std::size_t i = 0;
+    for (; i + 3 <= bytes.size(); i += 3) {
+      const std::uint32_t n = std::uint32_t(bytes[i]) << 16 | std::uint32_t(bytes[i + 1]) << 8 | std::uint32_t(bytes[i + 2]);
+      result.push_back(table[(n >> 18) & 0x3f]);
+      result.push_back(table[(n >> 12) & 0x3f]);
+      result.push_back(table[(n >> 6) & 0x3f]);
+      result.push_back(table[n & 0x3f]);
+    }
+
+    if (const auto rest = bytes.size() - i; rest != 0) {
+      const std::uint32_t n = std::uint32_t(bytes[i]) << 16 | (rest == 2 ? std::uint32_t(bytes[i + 1]) << 8 : 0);
+      result.push_back(table[(n >> 18) & 0x3f]);
+      result.push_back(table[(n >> 12) & 0x3f]);
+      result.push_back(rest == 2 ? table[(n >> 6) & 0x3f] : '=');
+      result.push_back('=');
+    }
+
+    return result;
+  }
+
+  /**
+   * @brief バイト列を小文字の16進文字列にする
+   */
+  inline auto to_hex(std::span<const unsigned char> bytes) -> std::string {
+    static constexpr char table[] = "0123456789abcdef";
+
+    std::string result;
+    result.reserve(bytes.size() * 2);
+
+    for (const auto b : bytes) {
+      result.push_back(table[b >> 4]);
+      result.push_back(table[b & 0xf]);
+    }
+
+    return result;
+  }
+}
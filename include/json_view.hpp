@@ -0,0 +1,594 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <optional>
+#include <charconv>
+#include <iterator>
+#include <ranges>
+#include <concepts>
+
+namespace chttpp::json::detail {
+
+  constexpr bool is_whitespace(char c) noexcept {
+    return c == ' ' or c == '\t' or c == '\n' or c == '\r';
+  }
+
+  constexpr auto skip_whitespace(const char* first, const char* last) noexcept -> const char* {
+    while (first != last and is_whitespace(*first)) {
+      ++first;
+    }
+    return first;
+  }
+
+  /**
+   * @brief 文字列の先頭（"の次）から、終端の"の位置を探す
+   * @return 終端の"の位置、見つからなければnullptr
+   * @details \"を終端と誤認しないように、直前の\の数を確認する
+   */
+  inline auto find_string_end(const char* first, const char* last) noexcept -> const char* {
+    const char* const begin = first;
+
+    while (first != last) {
+      const auto* quote = static_cast<const char*>(std::memchr(first, '"', static_cast<std::size_t>(last - first)));
+      if (quote == nullptr) {
+        return nullptr;
+      }
+
+      std::size_t backslashes = 0;
+      for (const char* p = quote; p != begin and *(p - 1) == '\\'; --p) {
+        ++backslashes;
+      }
+
+      if (backslashes % 2 == 0) {
+        return quote;
+      }
+
+      first = quote + 1;
+    }
+
+    return nullptr;
+  }
+
+  /**
+   * @brief 1つの値を読み飛ばす
+   * @param first 値の先頭（空白ではないこと）
+   * @return 値の直後の位置、値が不正な場合はnullptr
+   * @details 配列とオブジェクトは括弧の対応のみを確認し、中身の構文は検査しない
+   */
+  inline auto skip_value(const char* first, const char* last) noexcept -> const char* {
+    if (first == last) {
+      return nullptr;
+    }
+
+    switch (*first) {
+      case '"':
+      {
+        const char* end = find_string_end(first + 1, last);
+        return end != nullptr ? end + 1 : nullptr;
+      }
+      case '[': [[fallthrough]];
+      case '{':
+      {
+        std::size_t depth = 0;
+
+        for (const char* p = first; p != last; ++p) {
+          switch (*p) {
+            case '"':
+              p = find_string_end(p + 1, last);
+              if (p == nullptr) {
+                return nullptr;
+              }
+              break;
+            case '[': [[fallthrough]];
+            case '{':
+              ++depth;
+              break;
+            case ']': [[fallthrough]];
+            case '}':
+              if (--depth == 0) {
+                return p + 1;
+              }
+              break;
+            default:
+              break;
+          }
+        }
+
+        return nullptr;
+      }
+      default:
+      {
+        // 数値・true・false・null
+        const char* p = first;
+        while (p != last and *p != ',' and *p != ']' and *p != '}' and not is_whitespace(*p)) {
+          ++p;
+        }
+        return p;
+      }
+    }
+  }
+
+  inline void append_utf8(std::string& out, std::uint32_t cp) {
+    if (cp < 0x80) {
+      out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+      out.push_back(static_cast<char>(0xc0 | (cp >> 6)));
+      out.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+    } else if (cp < 0x10000) {
+      out.push_back(static_cast<char>(0xe0 | (cp >> 12)));
+      out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+      out.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+    } else {
+      out.push_back(static_cast<char>(0xf0 | (cp >> 18)));
+      out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3f)));
+      out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+      out.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+    }
+  }
+
+  inline auto parse_hex4(std::string_view str) noexcept -> std::optional<std::uint32_t> {
+    std::uint32_t value = 0;
+    if (str.size() < 4) {
+      return std::nullopt;
+    }
+    if (const auto [ptr, ec] = std::from_chars(str.data(), str.data() + 4, value, 16); ec != std::errc{} or ptr != str.data() + 4) {
+      return std::nullopt;
+    }
+    return value;
+  }
+
+  /**
+   * @brief エスケープシーケンスを含む文字列の中身（"を含まない）を展開する
+   * @return 不正なエスケープがある場合はfalse
+   */
+  inline bool unescape(std::string_view str, std::string& out) {
+    out.clear();
+    out.reserve(str.size());
+
+    while (not str.empty()) {
+      const auto pos = str.find('\\');
+      out.append(str.substr(0, pos));
+
+      if (pos == std::string_view::npos) {
+        break;
+      }
+
+      str.remove_prefix(pos + 1);
+      if (str.empty()) {
+        return false;
+      }
+
+      const char c = str.front();
+      str.remove_prefix(1);
+
+      switch (c) {
+        case '"':  out.push_back('"');  break;
+        case '\\': out.push_back('\\'); break;
+        case '/':  out.push_back('/');  break;
+        case 'b':  out.push_back('\b'); break;
+        case 'f':  out.push_back('\f'); break;
+        case 'n':  out.push_back('\n'); break;
+        case 'r':  out.push_back('\r'); break;
+        case 't':  out.push_back('\t'); break;
+        case 'u':
+        {
+          auto cp = parse_hex4(str);
+          if (not cp) {
+            return false;
+          }
+          str.remove_prefix(4);
+
+          // サロゲートペア
+          if (0xd800 <= *cp and *cp < 0xdc00) {
+            if (not str.starts_with("\\u")) {
+              return false;
+            }
+            const auto low = parse_hex4(str.substr(2));
+            if (not low or *low < 0xdc00 or 0xe000 <= *low) {
+              return false;
+            }
+            str.remove_prefix(6);
+            *cp = 0x10000 + ((*cp - 0xd800) << 10) + (*low - 0xdc00);
+          }
+
+          append_utf8(out, *cp);
+          break;
+        }
+        default:
+          return false;
+      }
+    }
+
+    return true;
+  }
+
+  /**
+   * @brief 配列の要素もしくはオブジェクトのメンバを順番に読み出すイテレータ
+   * @tparam Value json::value
+   * @tparam Element Valueもしくはjson::member
+   */
+  template<typename Value, typename Element>
+  class container_iterator {
+    const char* m_pos = nullptr;
+    const char* m_last = nullptr;
+    Element m_current{};
+    bool m_done = true;
+
+    void advance() {
+      const char* p = detail::skip_whitespace(m_pos, m_last);
+
+      // 最初の要素でなければ、区切りの,を読み飛ばす
+      if (p != m_last and *p == ',') {
+        p = detail::skip_whitespace(p + 1, m_last);
+      }
+
+      if (p == m_last or *p == ']' or *p == '}') {
+        m_done = true;
+        return;
+      }
+
+      if constexpr (not std::same_as<Element, Value>) {
+        if (*p != '"') {
+          m_done = true;
+          return;
+        }
+
+        const char* key_end = detail::find_string_end(p + 1, m_last);
+        if (key_end == nullptr) {
+          m_done = true;
+          return;
+        }
+
+        m_current.key = std::string_view{p + 1, key_end};
+
+        p = detail::skip_whitespace(key_end + 1, m_last);
+        if (p == m_last or *p != ':') {
+          m_done = true;
+          return;
+        }
+        p = detail::skip_whitespace(p + 1, m_last);
+      }
+
+      const char* value_end = detail::skip_value(p, m_last);
+      if (value_end == nullptr) {
+        m_done = true;
+        return;
+      }
+
+      if constexpr (not std::same_as<Element, Value>) {
+        m_current.value = Value{std::string_view{p, value_end}};
+      } else {
+        m_current = Value{std::string_view{p, value_end}};
+      }
+
+      m_pos = value_end;
+    }
+
+  public:
+
+    using iterator_concept = std::forward_iterator_tag;
+    using iterator_category = std::input_iterator_tag;
+    using value_type = Element;
+    using difference_type = std::ptrdiff_t;
+
+    container_iterator() = default;
+
+    // first : 開き括弧の次の位置
+    container_iterator(const char* first, const char* last)
+      : m_pos(first)
+      , m_last(last)
+      , m_done(false)
+    {
+      this->advance();
+    }
+
+    auto operator*() const noexcept -> const Element& {
+      return m_current;
+    }
+
+    auto operator->() const noexcept -> const Element* {
+      return &m_current;
+    }
+
+    auto operator++() -> container_iterator& {
+      this->advance();
+      return *this;
+    }
+
+    auto operator++(int) -> container_iterator {
+      auto copy = *this;
+      this->advance();
+      return copy;
+    }
+
+    friend bool operator==(const container_iterator& lhs, const container_iterator& rhs) noexcept {
+      if (lhs.m_done or rhs.m_done) {
+        return lhs.m_done == rhs.m_done;
+      }
+      return lhs.m_pos == rhs.m_pos;
+    }
+
+    friend bool operator==(const container_iterator& it, std::default_sentinel_t) noexcept {
+      return it.m_done;
+    }
+  };
+
+  template<typename Value, typename Element>
+  class container_range : public std::ranges::view_interface<container_range<Value, Element>> {
+    std::string_view m_text{};
+
+  public:
+
+    container_range() = default;
+
+    explicit container_range(std::string_view text)
+      : m_text(text)
+    {}
+
+    auto begin() const -> container_iterator<Value, Element> {
+      if (m_text.empty()) {
+        return {};
+      }
+      return { m_text.data() + 1, m_text.data() + m_text.size() };
+    }
+
+    auto end() const noexcept -> std::default_sentinel_t {
+      return std::default_sentinel;
+    }
+  };
+}
+
+namespace chttpp::json {
+
+  /**
+   * @brief JSONの値の種類
+   */
+  enum class kind {
+    null,
+    boolean,
+    number,
+    string,
+    array,
+    object,
+    // 存在しない要素、もしくは不正な値
+    invalid,
+  };
+
+  struct member;
+
+  /**
+   * @brief 元の文字列を参照する、遅延評価のJSON値
+   * @details 構文解析は要素へのアクセス時に必要な部分だけ行われ、DOMの構築やメモリ確保は行わない
+   * @details 元の文字列（レスポンスボディ）より長く生存してはならない
+   * @details 存在しない要素へのアクセスはkind::invalidの値を返し、その後のアクセスも全てinvalidになる
+   */
+  class value {
+    // 値のテキスト（前後の空白を含まない）、invalidの場合は空
+    std::string_view m_text{};
+
+  public:
+
+    using array_range = detail::container_range<value, value>;
+    using object_range = detail::container_range<value, member>;
+
+    value() = default;
+
+    /**
+     * @param text 値のテキスト、前後の空白は取り除かれる
+     */
+    explicit value(std::string_view text) noexcept {
+      const char* first = detail::skip_whitespace(text.data(), text.data() + text.size());
+      const char* last = text.data() + text.size();
+
+      while (first != last and detail::is_whitespace(*(last - 1))) {
+        --last;
+      }
+
+      m_text = std::string_view{first, last};
+    }
+
+    auto type() const noexcept -> kind {
+      if (m_text.empty()) {
+        return kind::invalid;
+      }
+
+      switch (m_text.front()) {
+        case 'n': return kind::null;
+        case 't': [[fallthrough]];
+        case 'f': return kind::boolean;
+        case '"': return kind::string;
+        case '[': return kind::array;
+        case '{': return kind::object;
+        default:  return kind::number;
+      }
+    }
+
+    /**
+     * @brief 有効な値であるか
+     */
+    explicit operator bool() const noexcept {
+      return not m_text.empty();
+    }
+
+    bool is_null() const noexcept {
+      return m_text == "null";
+    }
+
+    /**
+     * @brief 値のテキストをそのまま取得する
+     */
+    auto raw() const noexcept -> std::string_view {
+      return m_text;
+    }
+
+    /**
+     * @brief オブジェクトのメンバを取得する
+     * @details メンバは先頭から順番に探索される、見つからない場合はinvalidな値を返す
+     */
+    auto operator[](std::string_view key) const -> value;
+
+    /**
+     * @brief 配列の要素を取得する
+     * @details 先頭から順番に読み飛ばして探索される、範囲外の場合はinvalidな値を返す
+     */
+    auto operator[](std::size_t index) const -> value;
+
+    /**
+     * @brief 配列の要素の列、配列ではない場合は空
+     */
+    auto elements() const -> array_range;
+
+    /**
+     * @brief オブジェクトのメンバの列、オブジェクトではない場合は空
+     */
+    auto members() const -> object_range;
+
+    auto as_bool() const noexcept -> std::optional<bool> {
+      if (m_text == "true") {
+        return true;
+      }
+      if (m_text == "false") {
+        return false;
+      }
+      return std::nullopt;
+    }
+
+    /**
+     * @brief 整数として取得する
+     * @details 小数部や指数部を持つ場合、範囲外の場合はnullopt
+     */
+    auto as_int() const noexcept -> std::optional<std::int64_t> {
+      std::int64_t result{};
+      if (const auto [ptr, ec] = std::from_chars(m_text.data(), m_text.data() + m_text.size(), result); ec != std::errc{} or ptr != m_text.data() + m_text.size()) {
+        return std::nullopt;
+      }
+      return result;
+    }
+
+    auto as_double() const noexcept -> std::optional<double> {
+      if (this->type() != kind::number) {
+        return std::nullopt;
+      }
+
+      double result{};
+      if (const auto [ptr, ec] = std::from_chars(m_text.data(), m_text.data() + m_text.size(), result); ec != std::errc{} or ptr != m_text.data() + m_text.size()) {
+        return std::nullopt;
+      }
+      return result;
+    }
+
+    /**
+     * @brief 文字列の中身を、コピーせずに取得する
+     * @details エスケープシーケンスを含む場合はnullopt（as_string()を使用する）
+     */
+    auto as_string_view() const noexcept -> std::optional<std::string_view> {
+      if (this->type() != kind::string or m_text.size() < 2) {
+        return std::nullopt;
+      }
+
+      const auto content = m_text.substr(1, m_text.size() - 2);
+      if (content.find('\\') != std::string_view::npos) {
+        return std::nullopt;
+      }
+
+      return content;
+    }
+
+    /**
+     * @brief エスケープシーケンスを展開した文字列を取得する
+     */
+    auto as_string() const -> std::optional<std::string> {
+      if (this->type() != kind::string or m_text.size() < 2) {
+        return std::nullopt;
+      }
+
+      std::string result{};
+      if (not detail::unescape(m_text.substr(1, m_text.size() - 2), result)) {
+        return std::nullopt;
+      }
+
+      return result;
+    }
+  };
+
+  /**
+   * @brief オブジェクトのメンバ
+   * @details keyはエスケープシーケンスを展開していない生の文字列
+   */
+  struct member {
+    std::string_view key;
+    json::value value;
+  };
+
+  inline auto value::operator[](std::string_view key) const -> value {
+    if (this->type() != kind::object) {
+      return {};
+    }
+
+    // エスケープされたキーとの比較用
+    std::string decoded{};
+
+    for (const auto& [raw_key, member_value] : this->members()) {
+      if (raw_key.find('\\') == std::string_view::npos) {
+        if (raw_key == key) {
+          return member_value;
+        }
+      } else if (detail::unescape(raw_key, decoded) and decoded == key) {
+        return member_value;
+      }
+    }
+
+    return {};
+  }
+
+  inline auto value::operator[](std::size_t index) const -> value {
+    if (this->type() != kind::array) {
+      return {};
+    }
+
+    for (const auto& element : this->elements()) {
+      if (index-- == 0) {
+        return element;
+      }
+    }
+
+    return {};
+  }
+
+  inline auto value::elements() const -> array_range {
+    return array_range{this->type() == kind::array ? m_text : std::string_view{}};
+  }
+
+  inline auto value::members() const -> object_range {
+    return object_range{this->type() == kind::object ? m_text : std::string_view{}};
+  }
+
+  /**
+   * @brief JSON文字列を遅延評価のJSON値として参照する
+   */
+  inline auto parse(std::string_view text) noexcept -> value {
+    return value{text};
+  }
+}
+
+namespace chttpp {
+
+  /**
+   * @brief レスポンスボディをchttpp::json::valueとして参照する
+   * @details auto json = res | chttpp::as_json; のように使用する
+   * @details 結果は元のレスポンスボディを参照するので、http_resultは一時オブジェクトであってはならない
+   */
+  inline constexpr struct as_json_fn {
+    auto operator()(std::string_view body) const noexcept -> json::value {
+      return json::parse(body);
+    }
+  } as_json{};
+}
+
+namespace std::ranges {
+  template<typename Value, typename Element>
+  inline constexpr bool enable_borrowed_range<chttpp::json::detail::container_range<Value, Element>> = true;
+}
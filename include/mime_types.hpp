@@ -4,6 +4,7 @@
 #include <concepts>
 #include <ranges>
 #include <algorithm>
+#include <utility>
 
 namespace chttpp::mime_types::detail {
 
@@ -132,6 +133,7 @@ namespace chttpp::mime_types::inline subtypes {
   define_subtype(csv, discrete_types::text);
   define_subtype(html, discrete_types::text);
   define_subtype(javascript, discrete_types::text);
+  define_subtype(markdown, discrete_types::text);
 
   define_subtype(apng, discrete_types::image);
   define_subtype(avif, discrete_types::image);
@@ -173,10 +175,12 @@ namespace chttpp::mime_types::inline subtypes {
   define_subtype(json, discrete_types::application);
   define_subtype(pkcs8, discrete_types::application);
   define_subtype(msword, discrete_types::application);
+  define_subtype(wasm, discrete_types::application);
 
   // -で結合するsubtypeは-を_へ置換
   inline constexpr chttpp::mime_types::detail::subtype_t<13, discrete_types::application> octet_stream = {"octet-stream"};
   inline constexpr chttpp::mime_types::detail::subtype_t<22, discrete_types::application> x_www_form_urlencoded = {"x-www-form-urlencoded"};
+  inline constexpr chttpp::mime_types::detail::subtype_t<6, discrete_types::application> x_tar = {"x-tar"};
 
 #undef define_subtype
 }
@@ -195,8 +199,13 @@ namespace chttpp::mime_types::detail {
     wordprocessingml_t wordprocessingml{};
   };
 
+  struct microsoft_t {
+    subtype_t<sizeof("vnd.microsoft.icon"), image> icon = { "vnd.microsoft.icon" };
+  };
+
   struct vnd_t {
     apple_t apple{};
+    microsoft_t microsoft{};
     openxmlformats_officedocument_t openxmlformats_officedocument{};
   };
 
@@ -248,9 +257,68 @@ namespace chttpp::mime_types::inline subtypes {
   define_semi_subtype_lhs(atom, discrete_types::application);
 
   // xmlは単独でsubtypeになるし、+で結合してsubtypeとなることもある
-  define_semi_subtype_rhs(xml, D(image/svg), D(discrete_types::text), D(application/atom), D(application/vnd.apple.installer));
+  define_semi_subtype_rhs(xml, D(image/svg), D(discrete_types::text), D(discrete_types::application), D(application/atom), D(application/vnd.apple.installer));
 
 #undef D
 #undef define_semi_subtype_rhs
 #undef define_semi_subtype_lhs
-}
\ No newline at end of file
+}
+
+namespace chttpp::mime_types::detail {
+
+  /**
+   * @brief MIME Typeオブジェクトを静的記憶域に置く
+   * @details mime_typeは名前を自身で保持するため、string_viewで参照し続けるにはオブジェクトを生存させておく必要がある
+   */
+  template<auto MimeType>
+  inline constexpr auto static_mime_type = MimeType;
+}
+
+namespace chttpp::mime_types {
+
+  /**
+   * @brief ファイルの拡張子（先頭の.を含まない小文字）と、対応するMIME Typeの表
+   * @details 拡張子の昇順に並んでいる
+   */
+  inline constexpr std::pair<std::string_view, std::string_view> extension_table[] = {
+    {"aac", detail::static_mime_type<audio/aac>},
+    {"avif", detail::static_mime_type<image/avif>},
+    {"bin", detail::static_mime_type<application/octet_stream>},
+    {"bmp", detail::static_mime_type<image/bmp>},
+    {"css", detail::static_mime_type<text/css>},
+    {"csv", detail::static_mime_type<text/csv>},
+    {"doc", detail::static_mime_type<application/msword>},
+    {"docx", detail::static_mime_type<application/vnd.openxmlformats_officedocument.wordprocessingml.document>},
+    {"gif", detail::static_mime_type<image/gif>},
+    {"gz", detail::static_mime_type<application/gzip>},
+    {"htm", detail::static_mime_type<text/html>},
+    {"html", detail::static_mime_type<text/html>},
+    {"ico", detail::static_mime_type<image/vnd.microsoft.icon>},
+    {"jpeg", detail::static_mime_type<image/jpeg>},
+    {"jpg", detail::static_mime_type<image/jpeg>},
+    {"js", detail::static_mime_type<text/javascript>},
+    {"json", detail::static_mime_type<application/json>},
+    {"md", detail::static_mime_type<text/markdown>},
+    {"mjs", detail::static_mime_type<text/javascript>},
+    {"mp3", detail::static_mime_type<audio/mpeg>},
+    {"mp4", detail::static_mime_type<video/mp4>},
+    {"mpeg", detail::static_mime_type<video/mpeg>},
+    {"otf", detail::static_mime_type<font/otf>},
+    {"pdf", detail::static_mime_type<application/pdf>},
+    {"png", detail::static_mime_type<image/png>},
+    {"svg", detail::static_mime_type<image/svg+xml>},
+    {"tar", detail::static_mime_type<application/x_tar>},
+    {"ttf", detail::static_mime_type<font/ttf>},
+    {"txt", detail::static_mime_type<text/plain>},
+    {"wasm", detail::static_mime_type<application/wasm>},
+    {"wav", detail::static_mime_type<audio/wav>},
+    {"webm", detail::static_mime_type<video/webm>},
+    {"webp", detail::static_mime_type<image/webp>},
+    {"woff", detail::static_mime_type<font/woff>},
+    {"woff2", detail::static_mime_type<font/woff2>},
+    {"xml", detail::static_mime_type<application/xml>},
+    {"zip", detail::static_mime_type<application/zip>},
+  };
+
+  static_assert(std::ranges::is_sorted(extension_table, {}, &std::pair<std::string_view, std::string_view>::first));
+}
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <variant>
+#include <optional>
 #include <vector>
 #include <cstdint>
+#include <cstring>
 #include <type_traits>
 #include <concepts>
 #include <span>
@@ -20,6 +22,10 @@
 #include <ctime>
 #include <charconv>
 #include <climits>
+#include <cstddef>
+#include <bit>
+#include <atomic>
+#include <filesystem>
 
 #if __has_include(<memory_resource>)
 
@@ -33,6 +39,7 @@
 #endif
 
 #include "null_terminated_string_view.hpp"
+#include "mime_types.hpp"
 
 #ifdef _MSC_VER
 
@@ -44,6 +51,13 @@
 
 #endif
 
+#ifndef CHTTPP_RESPONSE_BODY_ALIGNMENT
+
+// レスポンスボディを格納するバッファのアライメント（64などを指定すればキャッシュライン境界に揃えられる）
+#define CHTTPP_RESPONSE_BODY_ALIGNMENT alignof(std::max_align_t)
+
+#endif
+
 
 namespace chttpp::inline types {
 
@@ -201,6 +215,73 @@ namespace chttpp::detail::inline util {
 
   template <typename T>
   using vector_buffer = pinned_buffer<vector_t<T>>;
+
+  /**
+   * @brief レスポンスボディバッファの先頭アドレスのアライメント
+   * @details response_data<T>()で読み替え可能な型のアライメントの上限となる
+   */
+  inline constexpr std::size_t response_body_alignment = CHTTPP_RESPONSE_BODY_ALIGNMENT;
+
+  static_assert(std::has_single_bit(response_body_alignment), "CHTTPP_RESPONSE_BODY_ALIGNMENT must be a power of 2.");
+  static_assert(alignof(std::max_align_t) <= response_body_alignment, "CHTTPP_RESPONSE_BODY_ALIGNMENT must be at least alignof(std::max_align_t).");
+
+#ifndef CHTTPP_DO_NOT_CUSTOMIZE_ALLOCATOR
+
+  /**
+   * @brief 上流のmemory_resourceに対して、指定されたアライメント以上での確保を強制する
+   * @details vector<char>の確保はアライメント1で要求されるため、そのままでは任意の型への読み替えが保証されない
+   */
+  class aligned_memory_resource : public std::pmr::memory_resource {
+    std::pmr::memory_resource* m_upstream;
+    std::size_t m_alignment;
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+      return m_upstream->allocate(bytes, std::max(alignment, m_alignment));
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+      m_upstream->deallocate(p, bytes, std::max(alignment, m_alignment));
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+      return this == &other;
+    }
+
+  public:
+
+    aligned_memory_resource(std::pmr::memory_resource* upstream, std::size_t alignment) noexcept
+      : m_upstream{upstream}
+      , m_alignment{alignment}
+    {}
+
+    aligned_memory_resource(const aligned_memory_resource&) = delete;
+    aligned_memory_resource& operator=(const aligned_memory_resource&) = delete;
+  };
+
+  /**
+   * @brief レスポンスボディの確保に使用するmemory_resourceを取得する
+   * @details レスポンスはagent等よりも長生きしうるので、静的に1つだけ用意する
+   * @details 上流は最初の呼び出し時点でのデフォルトリソース（リクエスト開始後にset_default_resource()を変更されるとしぬ）
+   */
+  inline auto response_body_resource() -> std::pmr::memory_resource* {
+    static aligned_memory_resource resource{std::pmr::get_default_resource(), response_body_alignment};
+    return &resource;
+  }
+
+#endif
+
+  /**
+   * @brief アライメントが保証された空のレスポンスボディバッファを作成する
+   */
+  inline auto make_response_body() -> vector_t<char> {
+#ifndef CHTTPP_DO_NOT_CUSTOMIZE_ALLOCATOR
+    return vector_t<char>{response_body_resource()};
+#else
+    // std::allocatorの場合、operator newの保証するアライメントまでしか揃えられない
+    static_assert(response_body_alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "CHTTPP_RESPONSE_BODY_ALIGNMENT cannot exceed __STDCPP_DEFAULT_NEW_ALIGNMENT__ when allocator customization is disabled.");
+    return {};
+#endif
+  }
 }
 
 namespace chttpp::detail::inline concepts {
@@ -226,6 +307,408 @@ namespace chttpp::detail::inline concepts {
   concept substantial =
     fundamental_type_with_substance<std::remove_reference_t<T>> or
     aggregate_with_substance<T>;
+
+  /**
+   * @brief バイトオーダーの変換（バイトスワップ）が意味を持つ型を表す
+   */
+  template <typename T>
+  concept byte_order_convertible =
+    (std::integral<T> or std::floating_point<T>) and
+    (not std::is_const_v<T>) and
+    (sizeof(T) == 1 or sizeof(T) == 2 or sizeof(T) == 4 or sizeof(T) == 8);
+}
+
+namespace chttpp::detail::inline util {
+
+  /**
+   * @brief 要素毎のバイトオーダーをその場で反転する
+   * @details 同サイズの符号なし整数として単純なループで変換することで、コンパイラによるベクトル化を期待する
+   */
+  template<byte_order_convertible T>
+  void byteswap_in_place(std::span<T> data) noexcept {
+    if constexpr (sizeof(T) != 1) {
+      using uint_t = std::conditional_t<sizeof(T) == 2, std::uint16_t, std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>>;
+
+      for (auto& v : data) {
+        v = std::bit_cast<T>(std::byteswap(std::bit_cast<uint_t>(v)));
+      }
+    }
+  }
+
+  /**
+   * @brief 指定されたバイトオーダーのデータを、実行環境のバイトオーダーへその場で変換する
+   */
+  template<byte_order_convertible T>
+  void to_native_endian(std::span<T> data, std::endian data_endian) noexcept {
+    if (data_endian != std::endian::native) {
+      byteswap_in_place(data);
+    }
+  }
+
+  /**
+   * @brief ファイルの拡張子（先頭の.を含まない）から、content-typeを推定する
+   * @details 対応はchttpp::mime_types::extension_tableによる
+   * @return 不明な拡張子の場合は空文字列
+   */
+  inline auto content_type_from_extension(std::string_view ext) noexcept -> std::string_view {
+    // 大文字小文字を区別しないように小文字化する（長い拡張子は表にない）
+    char lower[8]{};
+    if (std::size(lower) < ext.size()) {
+      return {};
+    }
+    std::ranges::transform(ext, lower, [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    const std::string_view key{lower, ext.size()};
+
+    const auto& table = chttpp::mime_types::extension_table;
+    const auto it = std::ranges::lower_bound(table, key, {}, &std::pair<std::string_view, std::string_view>::first);
+    if (it == std::ranges::end(table) or (*it).first != key) {
+      return {};
+    }
+
+    return (*it).second;
+  }
+
+  /**
+   * @brief Content-Rangeヘッダの値
+   */
+  struct content_range {
+    static constexpr std::uint64_t unknown_length = std::uint64_t(-1);
+
+    // 範囲を含まない（"bytes */length"）場合はfalse
+    bool has_range = false;
+    // 範囲の最初と最後の位置（閉区間）
+    std::uint64_t first = 0;
+    std::uint64_t last = 0;
+    // 全体の長さが不明（"bytes first-last/*"）の場合はunknown_length
+    std::uint64_t length = unknown_length;
+  };
+
+  /**
+   * @brief Content-Rangeヘッダの値（"bytes first-last/length"）をパースする
+   * @return 不正な値の場合は無効値
+   */
+  inline auto parse_content_range(std::string_view value) noexcept -> std::optional<content_range> {
+    if (not value.starts_with("bytes ")) {
+      return std::nullopt;
+    }
+    value.remove_prefix(6);
+
+    const auto slash_pos = value.find('/');
+    if (slash_pos == std::string_view::npos) {
+      return std::nullopt;
+    }
+
+    // 数値全体を読み取れた場合のみ成功とする
+    const auto parse_num = [](std::string_view str, std::uint64_t& out) -> bool {
+      const auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), out);
+      return ec == std::errc{} and ptr == str.data() + str.size();
+    };
+
+    content_range result{};
+
+    if (const auto range = value.substr(0, slash_pos); range != "*") {
+      const auto hyphen_pos = range.find('-');
+      if (hyphen_pos == std::string_view::npos or
+          not parse_num(range.substr(0, hyphen_pos), result.first) or
+          not parse_num(range.substr(hyphen_pos + 1), result.last) or
+          result.last < result.first)
+      {
+        return std::nullopt;
+      }
+      result.has_range = true;
+    }
+
+    if (const auto length = value.substr(slash_pos + 1); length != "*") {
+      if (not parse_num(length, result.length)) {
+        return std::nullopt;
+      }
+    } else if (not result.has_range) {
+      // "bytes */*"は不正
+      return std::nullopt;
+    }
+
+    return result;
+  }
+}
+
+namespace chttpp::detail::inline util {
+
+  /**
+   * @brief テンプレート引数に指定可能なコンパイル時文字列
+   */
+  template<std::size_t N>
+  struct fixed_string {
+    char str[N]{};
+
+    consteval fixed_string(const char(&literal)[N]) {
+      std::ranges::copy(literal, str);
+    }
+
+    constexpr auto view() const noexcept -> std::string_view {
+      return {str, N - 1};
+    }
+
+    static constexpr auto size() noexcept -> std::size_t {
+      return N - 1;
+    }
+  };
+}
+
+namespace chttpp::detail::inline percent_encoding {
+
+  /**
+   * @brief URLの非予約文字（RFC 3986 unreserved）か
+   */
+  constexpr bool is_unreserved(char c) noexcept {
+    return ('0' <= c and c <= '9') or ('A' <= c and c <= 'Z') or ('a' <= c and c <= 'z') or c == '-' or c == '.' or c == '_' or c == '~';
+  }
+
+  namespace swar {
+    inline constexpr std::uint64_t ones = 0x0101010101010101ull;
+    inline constexpr std::uint64_t low7 = ones * 0x7F;
+    inline constexpr std::uint64_t high = ones * 0x80;
+
+    /**
+     * @brief 各バイトがc（0x80未満）と等しい場合に、そのバイトの最上位ビットを立てる
+     */
+    constexpr auto equal(std::uint64_t word, std::uint8_t c) noexcept -> std::uint64_t {
+      const std::uint64_t x = word ^ (ones * c);
+      return ~(((x & low7) + low7) | x | low7);
+    }
+
+    /**
+     * @brief 各バイトがlo以上hi以下（いずれも0x80未満）の場合に、そのバイトの最上位ビットを立てる
+     * @details 下位7ビットのみで計算するため、バイト間で桁上がりは起こらない
+     */
+    constexpr auto in_range(std::uint64_t word, std::uint8_t lo, std::uint8_t hi) noexcept -> std::uint64_t {
+      const std::uint64_t x = word & low7;
+      return (ones * (128 + hi) - x) & ~word & (x + ones * (128 - lo)) & high;
+    }
+
+    /**
+     * @brief 8バイトの各バイトが非予約文字である場合に、そのバイトの最上位ビットを立てる
+     */
+    constexpr auto unreserved(std::uint64_t word) noexcept -> std::uint64_t {
+      return in_range(word, '0', '9') | in_range(word, 'A', 'Z') | in_range(word, 'a', 'z') |
+             equal(word, '-') | equal(word, '.') | equal(word, '_') | equal(word, '~');
+    }
+
+    inline auto load(const char* p) noexcept -> std::uint64_t {
+      std::uint64_t word;
+      std::memcpy(&word, p, sizeof(word));
+      return word;
+    }
+
+    /**
+     * @brief 最上位ビットの立っているバイトのうち、メモリ上で最初のものの位置
+     */
+    constexpr auto first_byte(std::uint64_t mask) noexcept -> std::size_t {
+      if constexpr (std::endian::native == std::endian::little) {
+        return static_cast<std::size_t>(std::countr_zero(mask)) / 8;
+      } else {
+        return static_cast<std::size_t>(std::countl_zero(mask)) / 8;
+      }
+    }
+  }
+
+  /**
+   * @brief pos以降で、最初にエンコードが必要な文字の位置を探す
+   * @details 8バイトずつまとめて判定する（SWAR）
+   * @return 位置、なければstr.size()
+   */
+  constexpr auto find_reserved(std::string_view str, std::size_t pos = 0) noexcept -> std::size_t {
+    if (not std::is_constant_evaluated()) {
+      for (; pos + 8 <= str.size(); pos += 8) {
+        if (const auto mask = ~swar::unreserved(swar::load(str.data() + pos)) & swar::high; mask != 0) {
+          return pos + swar::first_byte(mask);
+        }
+      }
+    }
+
+    for (; pos < str.size(); ++pos) {
+      if (not is_unreserved(str[pos])) {
+        return pos;
+      }
+    }
+
+    return str.size();
+  }
+
+  /**
+   * @brief パーセントエンコード後の長さ
+   * @param space_as_plus 空白を+にエンコードする（application/x-www-form-urlencoded）
+   */
+  constexpr auto percent_encoded_size(std::string_view str, bool space_as_plus = false) noexcept -> std::size_t {
+    std::size_t reserved = 0;
+    std::size_t spaces = 0;
+    std::size_t pos = 0;
+
+    if (not std::is_constant_evaluated()) {
+      for (; pos + 8 <= str.size(); pos += 8) {
+        const auto word = swar::load(str.data() + pos);
+        reserved += static_cast<std::size_t>(std::popcount(~swar::unreserved(word) & swar::high));
+        if (space_as_plus) {
+          spaces += static_cast<std::size_t>(std::popcount(swar::equal(word, ' ')));
+        }
+      }
+    }
+
+    for (; pos < str.size(); ++pos) {
+      reserved += not is_unreserved(str[pos]);
+      spaces += str[pos] == ' ';
+    }
+
+    return str.size() + 2 * reserved - (space_as_plus ? 2 * spaces : 0);
+  }
+
+  /**
+   * @brief パーセントエンコードした結果をoutへ書き込む
+   * @details outにはpercent_encoded_size()以上の領域が必要、非予約文字の連続はまとめてコピーする
+   * @return 書き込んだ末尾の次の位置
+   */
+  constexpr auto percent_encode_to(char* out, std::string_view str, bool space_as_plus = false) noexcept -> char* {
+    constexpr char hex[] = "0123456789ABCDEF";
+    std::size_t pos = 0;
+
+    while (pos < str.size()) {
+      const std::size_t run_end = find_reserved(str, pos);
+      out = std::ranges::copy(str.substr(pos, run_end - pos), out).out;
+
+      if (run_end == str.size()) {
+        break;
+      }
+
+      const auto c = static_cast<unsigned char>(str[run_end]);
+      if (space_as_plus and c == ' ') {
+        *out++ = '+';
+      } else {
+        *out++ = '%';
+        *out++ = hex[c >> 4];
+        *out++ = hex[c & 0xF];
+      }
+
+      pos = run_end + 1;
+    }
+
+    return out;
+  }
+
+  /**
+   * @brief パーセントエンコードした結果を文字列の末尾に追記する
+   */
+  template<typename String>
+  void append_percent_encoded(String& out, std::string_view str, bool space_as_plus = false) {
+    const std::size_t old_size = out.size();
+    out.resize(old_size + percent_encoded_size(str, space_as_plus));
+    percent_encode_to(out.data() + old_size, str, space_as_plus);
+  }
+
+  /**
+   * @brief 16進数の1桁を値に変換する
+   * @return 16進数の文字でなければ-1
+   */
+  constexpr auto hex_digit_value(char c) noexcept -> int {
+    if ('0' <= c and c <= '9') return c - '0';
+    if ('A' <= c and c <= 'F') return c - 'A' + 10;
+    if ('a' <= c and c <= 'f') return c - 'a' + 10;
+    return -1;
+  }
+
+  /**
+   * @brief パーセントエンコーディングを正規化して、文字列の末尾に追記する（RFC 3986 6.2.2.1, 6.2.2.2）
+   * @details 非予約文字を表す%XXはデコードし、それ以外の%XXは16進数を大文字にそろえる、不正な%はそのまま残す
+   * @param lower_case アルファベットを小文字にする（ホスト名用）
+   */
+  template<typename String>
+  void append_normalized_percent_encoding(String& out, std::string_view str, bool lower_case = false) {
+    constexpr char hex[] = "0123456789ABCDEF";
+
+    const auto append_run = [&](std::string_view run) {
+      if (lower_case) {
+        std::ranges::transform(run, std::back_inserter(out), [](char c) {
+          return ('A' <= c and c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+        });
+      } else {
+        out.append(run);
+      }
+    };
+
+    std::size_t pos = 0;
+
+    while (pos < str.size()) {
+      const std::size_t pct = std::min(str.find('%', pos), str.size());
+      append_run(str.substr(pos, pct - pos));
+
+      if (pct == str.size()) {
+        break;
+      }
+
+      const int hi = pct + 2 < str.size() ? hex_digit_value(str[pct + 1]) : -1;
+      const int lo = pct + 2 < str.size() ? hex_digit_value(str[pct + 2]) : -1;
+
+      if (hi < 0 or lo < 0) {
+        // 不正な%は、そのまま残す
+        out.push_back('%');
+        pos = pct + 1;
+        continue;
+      }
+
+      if (const char c = static_cast<char>(hi * 16 + lo); is_unreserved(c)) {
+        append_run({&c, 1});
+      } else {
+        out.push_back('%');
+        out.push_back(hex[hi]);
+        out.push_back(hex[lo]);
+      }
+
+      pos = pct + 3;
+    }
+  }
+
+  /**
+   * @brief URLの末尾に、クエリパラメータをエンコードして付加する
+   * @details URLに既にクエリがある場合は&で繋ぐ、フラグメントは取り除く
+   * @details 全パラメータのエンコード後の長さを求めてから、1度の伸長で書き込む（名前と値の空白は+になる）
+   */
+  template<typename String>
+  void append_query_params(String& url, std::span<const std::pair<std::string_view, std::string_view>> params) {
+    // フラグメントはブラウザでのみ意味があり、リクエストの一部ではない
+    if (const auto pos = std::string_view{url}.find('#'); pos != std::string_view::npos) {
+      url.resize(pos);
+    }
+
+    if (params.empty()) {
+      return;
+    }
+
+    const std::string_view url_view{url};
+    const auto query_pos = url_view.find('?');
+    // 空のクエリ、もしくは&で終わっている場合は区切りを追加しない
+    const bool need_separator = not (url_view.ends_with('?') or (query_pos != std::string_view::npos and url_view.ends_with('&')));
+
+    std::size_t length = need_separator;
+    for (const auto& [name, value] : params) {
+      length += percent_encoded_size(name, true) + percent_encoded_size(value, true) + 2;
+    }
+
+    const std::size_t old_size = url.size();
+    // 最後の&の分を除く
+    url.resize(old_size + length - 1);
+    char* out = url.data() + old_size;
+
+    if (need_separator) {
+      *out++ = query_pos == std::string_view::npos ? '?' : '&';
+    }
+
+    for (bool first = true; const auto& [name, value] : params) {
+      if (not std::exchange(first, false)) {
+        *out++ = '&';
+      }
+      out = percent_encode_to(out, name, true);
+      *out++ = '=';
+      out = percent_encode_to(out, value, true);
+    }
+  }
 }
 
 namespace chttpp::detail {
@@ -286,6 +769,148 @@ namespace chttpp::detail {
 
 namespace chttpp::detail {
 
+  /**
+   * @brief 入力を分割して与えられる、非暗号学的な64bitハッシュ
+   * @details MurmurHash64Aの混合関数を8バイト毎に適用し、長さは最後に混ぜる
+   * @details 入力の区切り方やエンディアンによらず、同じバイト列には同じ値を返す
+   */
+  class fingerprint64 {
+    static constexpr std::uint64_t mul = 0xc6a4a7935bd1e995ull;
+    static constexpr int shift = 47;
+
+    std::uint64_t m_state = 0x9e3779b97f4a7c15ull;
+    std::uint64_t m_total_len = 0;
+    unsigned char m_tail[8]{};
+    std::size_t m_tail_len = 0;
+
+    // リトルエンディアンとして読む（リトルエンディアン環境では1命令になる）
+    static constexpr auto load_le(const unsigned char* p, std::size_t len = 8) noexcept -> std::uint64_t {
+      std::uint64_t word = 0;
+      for (std::size_t i = 0; i < len; ++i) {
+        word |= std::uint64_t(p[i]) << (8 * i);
+      }
+      return word;
+    }
+
+    constexpr void mix(std::uint64_t k) noexcept {
+      k *= mul;
+      k ^= k >> shift;
+      k *= mul;
+
+      m_state ^= k;
+      m_state *= mul;
+    }
+
+  public:
+
+    void update(std::string_view data) noexcept {
+      auto* ptr = reinterpret_cast<const unsigned char*>(data.data());
+      std::size_t len = data.size();
+
+      m_total_len += len;
+
+      // 前回の端数があれば、まず8バイトを埋める
+      if (m_tail_len != 0) {
+        const std::size_t fill_len = std::min(sizeof(m_tail) - m_tail_len, len);
+        std::copy_n(ptr, fill_len, m_tail + m_tail_len);
+
+        m_tail_len += fill_len;
+        ptr += fill_len;
+        len -= fill_len;
+
+        if (m_tail_len < sizeof(m_tail)) {
+          return;
+        }
+
+        this->mix(load_le(m_tail));
+        m_tail_len = 0;
+      }
+
+      for (; 8 <= len; ptr += 8, len -= 8) {
+        this->mix(load_le(ptr));
+      }
+
+      std::copy_n(ptr, len, m_tail);
+      m_tail_len = len;
+    }
+
+    [[nodiscard]]
+    constexpr auto value() const noexcept -> std::uint64_t {
+      std::uint64_t h = m_state;
+
+      if (m_tail_len != 0) {
+        h ^= load_le(m_tail, m_tail_len);
+        h *= mul;
+      }
+
+      h ^= m_total_len * mul;
+
+      h ^= h >> shift;
+      h *= mul;
+      h ^= h >> shift;
+
+      return h;
+    }
+  };
+
+  /**
+   * @brief url_info::normalize()の設定
+   */
+  struct url_normalize_config {
+    // クエリパラメータを名前でソートする（同名のパラメータの順序は保たれる）
+    bool sort_query = false;
+  };
+
+  /**
+   * @brief 正規化したURLとそのフィンガープリント
+   */
+  struct normalized_url {
+    string_t url;
+    std::uint64_t fingerprint = 0;
+  };
+
+  /**
+   * @brief agentのベースURLに付加するパス
+   * @details 文字列の他、URLへパスを直接書き込むオブジェクト（route<...>(args...)の結果など）を参照できる
+   * @details 参照先はリクエストの完了まで生存している必要がある
+   */
+  class url_path_ref {
+    std::string_view m_path{};
+    const void* m_writer = nullptr;
+    void (*m_write)(const void*, string_t&) = nullptr;
+
+  public:
+
+    template<std::convertible_to<std::string_view> S>
+    url_path_ref(const S& path) noexcept
+      : m_path(path)
+    {}
+
+    /**
+     * @brief write_path(string_t&)によってパスを書き込むオブジェクトを参照する
+     */
+    template<typename W>
+      requires (not std::convertible_to<W, std::string_view>) and
+               requires(const W& writer, string_t& url) {
+                 writer.write_path(url);
+               }
+    url_path_ref(const W& writer) noexcept
+      : m_writer(std::addressof(writer))
+      , m_write([](const void* ptr, string_t& url) { static_cast<const W*>(ptr)->write_path(url); })
+    {}
+
+    /**
+     * @brief URLの末尾にパスを追記する
+     */
+    void append_to(string_t& url) const {
+      if (m_write != nullptr) {
+        m_write(m_writer, url);
+      } else {
+        url.append(m_path);
+      }
+    }
+  };
+
   class url_info {
     string_t m_urlstr;
     
@@ -293,6 +918,8 @@ namespace chttpp::detail {
     bool m_is_ipv4_host = false;
     bool m_is_ipv6_host = false;
 
+    // Authority部（userinfoを含む）の開始位置
+    std::size_t m_authority_begin_pos = 0;
     // ホスト部の開始位置
     std::size_t m_host_begin_pos;
     // パス部分の開始位置、必ず'/'で始まる
@@ -316,11 +943,15 @@ namespace chttpp::detail {
       // example.com/...
       // example.com
 
-      // httpから始まっているか
-      if (m_urlstr.starts_with("http")) {
+      // httpから始まっているか（スキームは大文字小文字を区別しない）
+      constexpr auto ieq = [](std::string_view str, std::string_view lower) {
+        return std::ranges::equal(str, lower, [](char a, char b) { return (a | 0x20) == b; });
+      };
+
+      if (ieq(std::string_view{m_urlstr}.substr(0, 4), "http")) {
         pos = 4;
         // httpsであるか
-        if (m_urlstr[pos] != 's') {
+        if ((m_urlstr[pos] | 0x20) != 's') {
           m_is_https = false;
         } else {
           // sを消費
@@ -346,6 +977,7 @@ namespace chttpp::detail {
       }
 
       // Authority（ホスト部を含むURLの部分）のパース
+      m_authority_begin_pos = pos;
       m_host_begin_pos = pos;
 
       // Authorityの終わりを見つける
@@ -470,6 +1102,81 @@ namespace chttpp::detail {
       return true;
     }
 
+    /**
+     * @brief url[begin, end)のパスから、ドットセグメントを取り除く（RFC 3986 5.2.4）
+     * @details パスは'/'で始まっている必要がある、取り除くことで短くなるだけなので、その場で詰めて書き込む
+     */
+    static void remove_dot_segments(string_t& url, const std::size_t begin) {
+      assert(begin < url.size() and url[begin] == '/');
+
+      const std::size_t end = url.size();
+      // 書き込み位置と読み出し位置、常にw <= r
+      std::size_t w = begin;
+      std::size_t r = begin;
+
+      while (r < end) {
+        // rは常に'/'を指し、[r, seg_end)が1つのセグメント
+        const std::size_t seg_end = std::min(url.find('/', r + 1), end);
+        const auto segment = std::string_view{url}.substr(r + 1, seg_end - r - 1);
+
+        if (segment == "." or segment == "..") {
+          if (segment == ".." and begin < w) {
+            // 出力済みの最後のセグメントを取り除く
+            w = url.rfind('/', w - 1);
+          }
+          if (seg_end == end) {
+            // "/a/.."のように終わる場合は、'/'で終わる
+            url[w++] = '/';
+          }
+        } else {
+          if (w != r) {
+            std::copy(url.begin() + r, url.begin() + seg_end, url.begin() + w);
+          }
+          w += seg_end - r;
+        }
+
+        r = seg_end;
+      }
+
+      if (w == begin) {
+        url[w++] = '/';
+      }
+
+      url.resize(w);
+    }
+
+    /**
+     * @brief url[begin, )のクエリパラメータを名前でソートする
+     * @details 同名のパラメータの順序は保たれる、空のパラメータ（"&&"）は取り除かれる
+     */
+    static void sort_query_params(string_t& url, const std::size_t begin) {
+      const auto query = std::string_view{url}.substr(begin);
+
+      vector_t<std::string_view> params;
+      for (std::size_t pos = 0; pos <= query.size();) {
+        const std::size_t amp = std::min(query.find('&', pos), query.size());
+        if (pos < amp) {
+          params.push_back(query.substr(pos, amp - pos));
+        }
+        pos = amp + 1;
+      }
+
+      std::ranges::stable_sort(params, {}, [](std::string_view param) {
+        return param.substr(0, param.find('='));
+      });
+
+      string_t sorted;
+      sorted.reserve(query.size());
+      for (auto param : params) {
+        if (not sorted.empty()) {
+          sorted += '&';
+        }
+        sorted.append(param);
+      }
+
+      url.replace(begin, string_t::npos, sorted);
+    }
+
   public:
 
     /*[[nodiscard]]
@@ -579,8 +1286,105 @@ namespace chttpp::detail {
       return m_is_ipv6_host;
     }
 
+    /**
+     * @brief 正規化したURLと、そのフィンガープリントを求める
+     * @details スキームとホストの小文字化、デフォルトポートの省略、パーセントエンコーディングの正規化、ドットセグメントの除去を行う（RFC 3986 6.2.2, 6.2.3）
+     * @details スキームの省略されたURLはhttpsとして扱い、フラグメントは取り除く
+     * @details フィンガープリントは正規化した部分を書き出す毎に計算するため、URLの再走査は行わない
+     * @return 無効なURLの場合、空のURLとフィンガープリント0
+     */
+    [[nodiscard]]
+    auto normalize(url_normalize_config cfg = {}) const -> normalized_url {
+      if (not is_valid()) {
+        return {};
+      }
+
+      const std::string_view url = m_urlstr;
+
+      normalized_url result{};
+      string_t& out = result.url;
+      fingerprint64 hasher{};
+
+      out.reserve(url.size() + 8);
+      out.append(m_is_https ? "https://" : "http://");
+
+      // userinfo
+      append_normalized_percent_encoding(out, url.substr(m_authority_begin_pos, m_host_begin_pos - m_authority_begin_pos));
+
+      // ホストとポート
+      auto host = url.substr(m_host_begin_pos, m_path_begin_pos - m_host_begin_pos);
+      std::string_view port{};
+
+      if (const auto colon = host.rfind(':'); colon != std::string_view::npos and (not m_is_ipv6_host or host.rfind(']') < colon)) {
+        port = host.substr(colon + 1);
+        host = host.substr(0, colon);
+      }
+
+      append_normalized_percent_encoding(out, host, true);
+
+      if (not port.empty()) {
+        std::uint16_t port_num;
+
+        if (const auto [ptr, ec] = std::from_chars(port.data(), port.data() + port.size(), port_num); ec == std::errc{} and ptr == port.data() + port.size()) {
+          // デフォルトポートは省略し、それ以外は先頭の0を除いて書き直す
+          if (port_num != (m_is_https ? 443 : 80)) {
+            char buf[8];
+            const auto [end, _] = std::to_chars(buf, buf + sizeof(buf), port_num);
+
+            out += ':';
+            out.append(buf, end);
+          }
+        } else {
+          out += ':';
+          out.append(port);
+        }
+      }
+
+      hasher.update(out);
+
+      // パスとクエリ、フラグメントは除く
+      auto path_and_query = url.substr(m_path_begin_pos);
+      path_and_query = path_and_query.substr(0, path_and_query.find('#'));
+
+      const auto query_pos = path_and_query.find('?');
+      const auto path = path_and_query.substr(0, query_pos);
+
+      const std::size_t path_begin = out.size();
+
+      if (path.empty()) {
+        out += '/';
+      } else {
+        append_normalized_percent_encoding(out, path);
+        remove_dot_segments(out, path_begin);
+      }
+
+      hasher.update(std::string_view{out}.substr(path_begin));
+
+      if (query_pos != std::string_view::npos) {
+        const std::size_t query_begin = out.size();
+
+        out += '?';
+        append_normalized_percent_encoding(out, path_and_query.substr(query_pos + 1));
+
+        if (cfg.sort_query) {
+          sort_query_params(out, query_begin + 1);
+        }
+
+        hasher.update(std::string_view{out}.substr(query_begin));
+      }
+
+      result.fingerprint = hasher.value();
+
+      return result;
+    }
+
+    /**
+     * @brief パスとURLパラメータを付加したリクエストURLを一時的に構成する
+     * @details 戻り値のオブジェクトの生存中はfull_url()が構成したURLを返し、破棄されると元のURLに戻る
+     * @param params エンコードしてクエリに付加するURLパラメータ
+     */
     [[nodiscard]]
-    auto append_path(std::string_view path) & {
+    auto append_path(const url_path_ref& path, std::span<const std::pair<std::string_view, std::string_view>> params = {}) & {
       class raii {
         string_t& str;
         std::size_t pos;
@@ -613,16 +1417,20 @@ namespace chttpp::detail {
       // 元の長さ
       const auto org_len = m_urlstr.length();
 
+      path.append_to(m_urlstr);
+
       // アンカー（'#'）は除く
-      path = path.substr(0, path.find_first_of('#'));
+      if (const auto anchor_pos = m_urlstr.find('#', org_len); anchor_pos != string_t::npos) {
+        m_urlstr.resize(anchor_pos);
+      }
 
-      if (m_urlstr.back() == '/' and path.front() == '/') {
+      if (m_urlstr[org_len - 1] == '/' and org_len < m_urlstr.length() and m_urlstr[org_len] == '/') {
         // '/'が重複する場合は取り除いておく
-        m_urlstr.append(path.substr(1));
-      } else {
-        m_urlstr.append(path);
+        m_urlstr.erase(org_len, 1);
       }
 
+      append_query_params(m_urlstr, params);
+
       // RAIIによって、後で元の長さに切り詰めることで元のURL先頭部分を復帰する
       return raii{m_urlstr, org_len};
     }
@@ -1255,6 +2063,30 @@ namespace chttpp::detail::inline config {
       socks5,
       socks5h,
     };
+
+    /**
+     * @brief レスポンスボディを受け取るコールバックから、転送の継続を指示する
+     */
+    enum class receive_status {
+      // 転送を継続する
+      proceed,
+      // 転送を中断する（リクエストは失敗する）
+      abort,
+      // 転送を一時停止する（同じデータが再開後に再度渡される）
+      pause,
+    };
+
+    /**
+     * @brief ダウンロードしたファイルをストレージへ同期するタイミング
+     */
+    enum class fsync_policy {
+      // 同期しない（OSに任せる）
+      none,
+      // ダウンロード完了時に1度だけ同期する
+      on_complete,
+      // バッファをファイルへ書き出すたびに同期する
+      every_flush,
+    };
   }
 
   struct authorization_config {
@@ -1269,12 +2101,369 @@ namespace chttpp::detail::inline config {
     authorization_config auth{};
   };
 
+  /**
+   * @brief レスポンスボディをチャンク毎に受け取ることのできる型
+   * @details 戻り値型はvoidもしくはreceive_status
+   */
+  template<typename F>
+  concept body_receiver =
+    std::invocable<F&, std::span<const char>> and
+    (std::same_as<std::invoke_result_t<F&, std::span<const char>>, void> or
+     std::same_as<std::invoke_result_t<F&, std::span<const char>>, receive_status>);
+
+  /**
+   * @brief body_receiverを呼び出し、戻り値をreceive_statusに揃える
+   */
+  template<body_receiver F>
+  auto invoke_receiver(F& receiver, std::span<const char> chunk) -> receive_status {
+    if constexpr (std::same_as<std::invoke_result_t<F&, std::span<const char>>, void>) {
+      std::invoke(receiver, chunk);
+      return receive_status::proceed;
+    } else {
+      return std::invoke(receiver, chunk);
+    }
+  }
+
+  /**
+   * @brief リクエスト時にbody_receiverが指定されていないことを表すタグ型
+   * @details この場合、streaming_receiverの指定に応じてレスポンスボディを受け取る
+   */
+  struct default_receiver_t {};
+
 #ifdef __cpp_lib_move_only_function
-  using streaming_callback = std::move_only_function<void(std::span<const char>)>;
+  using streaming_callback_base = std::move_only_function<receive_status(std::span<const char>)>;
 #else
-  using streaming_callback = std::function<void(std::span<const char>)>;
+  using streaming_callback_base = std::function<receive_status(std::span<const char>)>;
 #endif
 
+  /**
+   * @brief streaming_receiverに指定するコールバックの型消去ラッパ
+   * @details 戻り値型がvoidのものも受け付け、その場合は常にreceive_status::proceedを返すものとして扱う
+   */
+  class streaming_callback {
+    streaming_callback_base m_callback;
+
+  public:
+
+    streaming_callback() = default;
+
+    streaming_callback(std::nullptr_t) noexcept {}
+
+    template<body_receiver F>
+      requires (not std::same_as<std::remove_cvref_t<F>, streaming_callback>)
+    streaming_callback(F&& f)
+      : m_callback{[fun = std::forward<F>(f)](std::span<const char> chunk) mutable -> receive_status {
+          return invoke_receiver(fun, chunk);
+        }}
+    {}
+
+    explicit operator bool() const noexcept {
+      return bool(m_callback);
+    }
+
+    auto operator()(std::span<const char> chunk) -> receive_status {
+      return m_callback(chunk);
+    }
+  };
+
+  /**
+   * @brief receive_status::pauseで一時停止された転送の再開を制御する
+   * @details リクエストよりも長く生存する必要がある。resume()は任意のスレッドから呼び出し可能
+   */
+  class flow_control {
+    std::atomic<bool> m_resume_requested{false};
+
+  public:
+
+    flow_control() = default;
+
+    flow_control(const flow_control&) = delete;
+    flow_control& operator=(const flow_control&) = delete;
+
+    /**
+     * @brief 一時停止中の転送の再開を要求する
+     * @details 一時停止されていない時の要求は、その後の一時停止に対して適用されるとは限らない
+     */
+    void resume() noexcept {
+      m_resume_requested.store(true, std::memory_order_release);
+      m_resume_requested.notify_one();
+    }
+
+    /**
+     * @brief 再開要求があればそれを消費してtrueを返す
+     */
+    bool consume_resume() noexcept {
+      return m_resume_requested.exchange(false, std::memory_order_acq_rel);
+    }
+
+    /**
+     * @brief 再開要求があるまで待機し、それを消費する
+     */
+    void wait_resume() noexcept {
+      while (not consume_resume()) {
+        m_resume_requested.wait(false, std::memory_order_acquire);
+      }
+    }
+  };
+
+  /**
+   * @brief ボディの受信前に得られるレスポンスの情報
+   */
+  struct response_head {
+    std::uint16_t status;
+    // Content-Length（不明な場合は無効値）
+    std::optional<std::uint64_t> content_length;
+    std::string_view content_type;
+    const header_t* headers;
+
+    /**
+     * @brief 名前（小文字）を指定してレスポンスヘッダの値を取得する
+     * @details リダイレクトが行われた場合、それまでのレスポンスのヘッダも含まれる
+     */
+    auto header(std::string_view name) const -> std::string_view {
+      if (const auto pos = headers->find(name); pos != headers->end()) {
+        return (*pos).second;
+      }
+      return {};
+    }
+  };
+
+  /**
+   * @brief レスポンスヘッダを受信した時点で決定する、ボディの扱い
+   */
+  class body_action {
+  public:
+    enum class kind {
+      // メモリ（レスポンスのボディ）へ受信する
+      keep,
+      // 転送を中断する（リクエストは失敗する）
+      abort,
+      // 受信したボディを捨てる
+      discard,
+      // ファイルへ書き込む
+      file,
+    };
+
+  private:
+    kind m_kind;
+    std::size_t m_reserve = 0;
+    std::filesystem::path m_path{};
+
+    explicit body_action(kind k) noexcept
+      : m_kind{k}
+    {}
+
+  public:
+
+    /**
+     * @brief メモリへ受信する
+     * @param reserve 事前に確保する長さ
+     */
+    static auto keep(std::size_t reserve = 0) noexcept -> body_action {
+      body_action action{kind::keep};
+      action.m_reserve = reserve;
+      return action;
+    }
+
+    static auto abort() noexcept -> body_action {
+      return body_action{kind::abort};
+    }
+
+    static auto discard() noexcept -> body_action {
+      return body_action{kind::discard};
+    }
+
+    /**
+     * @brief 指定したファイルへ書き込む（既存のファイルは上書きされる）
+     */
+    static auto to_file(std::filesystem::path path) -> body_action {
+      body_action action{kind::file};
+      action.m_path = std::move(path);
+      return action;
+    }
+
+    auto action() const noexcept -> kind {
+      return m_kind;
+    }
+
+    auto reserve() const noexcept -> std::size_t {
+      return m_reserve;
+    }
+
+    auto path() const noexcept -> const std::filesystem::path& {
+      return m_path;
+    }
+  };
+
+#ifdef __cpp_lib_move_only_function
+  using response_inspector = std::move_only_function<body_action(const response_head&)>;
+#else
+  using response_inspector = std::function<body_action(const response_head&)>;
+#endif
+
+#ifdef __cpp_lib_move_only_function
+  using body_read_callback = std::move_only_function<std::size_t(std::span<char>)>;
+  using body_seek_callback = std::move_only_function<bool(std::size_t)>;
+#else
+  using body_read_callback = std::function<std::size_t(std::span<char>)>;
+  using body_seek_callback = std::function<bool(std::size_t)>;
+#endif
+
+  /**
+   * @brief リクエストボディを逐次読み出して送信するためのソース
+   * @details 読み出し関数は渡されたバッファにデータを書き込み、書き込んだバイト数を返す。0を返すとボディの終端とみなす
+   * @details 長さが不明な場合、チャンク形式（Transfer-Encoding: chunked）で送信される
+   * @details シーク関数が無い場合は読み直せないため、リダイレクト（307/308）や認証による再送信は失敗する
+   */
+  class body_reader {
+    body_read_callback m_read;
+    std::size_t m_length;
+    // 読み出し位置を先頭からのオフセットに移動する関数（読み直せないソースでは空）
+    body_seek_callback m_seek{};
+    // データがメモリ上に連続して存在する場合、その領域（読み出し関数を経由せずに送信できる）
+    std::span<const char> m_contiguous{};
+    // 1回の読み出しで要求するバイト数の目安（0の場合は下層のデフォルト）
+    std::size_t m_block_size = 0;
+
+  public:
+
+    static constexpr std::size_t unknown_length = static_cast<std::size_t>(-1);
+
+    explicit body_reader(body_read_callback read, std::size_t length = unknown_length)
+      : m_read{std::move(read)}
+      , m_length{length}
+    {}
+
+    /**
+     * @brief データが連続したメモリ領域にある場合、それを通知する
+     * @details 領域の生存期間はreaderが保持するオブジェクトによって保証されている必要がある
+     */
+    auto with_contiguous(std::span<const char> data) && -> body_reader&& {
+      m_contiguous = data;
+      return std::move(*this);
+    }
+
+    /**
+     * @brief 1回の読み出しで要求するバイト数の目安を指定する
+     */
+    auto with_block_size(std::size_t block_size) && -> body_reader&& {
+      m_block_size = block_size;
+      return std::move(*this);
+    }
+
+    /**
+     * @brief 読み出し位置を変更する関数を指定する
+     * @details seekは先頭からのオフセットを受け取り、移動できなかった場合はfalseを返す
+     */
+    auto with_seek(body_seek_callback seek) && -> body_reader&& {
+      m_seek = std::move(seek);
+      return std::move(*this);
+    }
+
+    body_reader(body_reader&&) = default;
+    body_reader& operator=(body_reader&&) & = default;
+
+    auto read(std::span<char> buffer) -> std::size_t {
+      return m_read(buffer);
+    }
+
+    bool can_seek() const noexcept {
+      return static_cast<bool>(m_seek);
+    }
+
+    /**
+     * @brief 読み出し位置を先頭からoffsetの位置に移動する
+     */
+    bool seek(std::size_t offset) {
+      return m_seek and m_seek(offset);
+    }
+
+    bool has_length() const noexcept {
+      return m_length != unknown_length;
+    }
+
+    auto length() const noexcept -> std::size_t {
+      return m_length;
+    }
+
+    auto contiguous() const noexcept -> std::span<const char> {
+      return m_contiguous;
+    }
+
+    auto block_size() const noexcept -> std::size_t {
+      return m_block_size;
+    }
+  };
+
+  /**
+   * @brief 固定長ブロックのLRUキャッシュ
+   * @details 容量は小さい（数十ブロック程度）ことを想定し、追い出すブロックは線形探索で決定する
+   */
+  class block_cache {
+    struct entry {
+      std::uint64_t last_used;
+      vector_t<char> data;
+    };
+
+    umap_t<std::uint64_t, entry> m_blocks{};
+    std::size_t m_capacity;
+    std::uint64_t m_tick = 0;
+
+  public:
+
+    explicit block_cache(std::size_t capacity)
+      : m_capacity{std::max<std::size_t>(capacity, 1)}
+    {}
+
+    /**
+     * @brief ブロックを検索し、最近使用したものとして記録する
+     * @return 見つからない場合はnullptr、ポインタは次のinsert()またはclear()まで有効
+     */
+    auto find(std::uint64_t index) -> const vector_t<char>* {
+      const auto it = m_blocks.find(index);
+      if (it == m_blocks.end()) {
+        return nullptr;
+      }
+
+      (*it).second.last_used = ++m_tick;
+      return &(*it).second.data;
+    }
+
+    bool contains(std::uint64_t index) const {
+      return m_blocks.contains(index);
+    }
+
+    /**
+     * @brief ブロックを追加する、容量を超える場合は最も長く使用されていないブロックを追い出す
+     */
+    void insert(std::uint64_t index, std::span<const char> data) {
+      if (auto it = m_blocks.find(index); it != m_blocks.end()) {
+        (*it).second.data.assign(data.begin(), data.end());
+        (*it).second.last_used = ++m_tick;
+        return;
+      }
+
+      if (m_capacity <= m_blocks.size()) {
+        const auto lru = std::ranges::min_element(m_blocks, {}, [](const auto& pair) { return pair.second.last_used; });
+        m_blocks.erase(lru);
+      }
+
+      m_blocks.emplace(index, entry{ ++m_tick, vector_t<char>(data.begin(), data.end()) });
+    }
+
+    void clear() noexcept {
+      m_blocks.clear();
+    }
+
+    auto size() const noexcept -> std::size_t {
+      return m_blocks.size();
+    }
+
+    auto capacity() const noexcept -> std::size_t {
+      return m_capacity;
+    }
+  };
+
 #define common_request_config \
     vector_t<std::pair<std::string_view, std::string_view>> headers{}; \
     vector_t<std::pair<std::string_view, std::string_view>> params{}; \
@@ -1294,10 +2483,32 @@ namespace chttpp::detail::inline config {
 
 #undef common_request_config
 
+  /**
+   * @brief レスポンスボディを受信するバッファのメモリ使用量の制限
+   * @details 各値が0の場合は制限しない、リクエスト毎の指定はagentに指定したものより優先される
+   */
+  struct body_budget {
+    // これを超える長さのボディは、メモリではなく一時ファイルに保持する
+    std::size_t spill_threshold = 0;
+    // これを超える長さのボディは受信しない（Content-Lengthが分かる場合、ボディの受信前にエラーとなる）
+    std::size_t max_body_size = 0;
+
+    /**
+     * @brief 指定されていない値をfallbackの値で補ったものを返す
+     */
+    auto or_else(const body_budget& fallback) const noexcept -> body_budget {
+      return {
+        .spill_threshold = spill_threshold != 0 ? spill_threshold : fallback.spill_threshold,
+        .max_body_size = max_body_size != 0 ? max_body_size : fallback.max_body_size
+      };
+    }
+  };
+
   struct agent_initial_config {
     http_ver_cfg version = http_version::http2;
     std::chrono::milliseconds timeout{30000};
     proxy_config proxy{};
+    body_budget budget{};
   };
 
   struct agent_request_config {
@@ -1313,6 +2524,61 @@ namespace chttpp::detail::inline config {
     vector_t<std::pair<std::string_view, std::string_view>> params{};
     authorization_config auth{};
     streaming_callback streaming_receiver{};
+    // receive_status::pauseによる一時停止からの再開を制御する（nullptrの場合、一時停止はすぐに再開される）
+    flow_control* flow = nullptr;
+    body_budget budget{};
+    // ボディの受信前に呼ばれ、ボディの扱いを決定する
+    response_inspector inspector{};
+    // trueの場合、自動解凍の設定によらず圧縮を要求しない（Rangeを圧縮前の表現に対して指定する場合など）
+    bool identity_encoding = false;
+    // 0以外の場合、agentのタイムアウト（転送全体）の代わりに、この時間受信が途絶えた場合にタイムアウトとする（libcurlのみ）
+    std::chrono::milliseconds idle_timeout{ 0 };
+  };
+
+  struct download_config {
+    // 既存のファイルがある場合、その末尾から続きをダウンロードする
+    bool resume = true;
+    // Content-Lengthが分かる場合、事前にファイルの領域を確保する
+    bool preallocate = true;
+    fsync_policy sync = fsync_policy::none;
+    // ファイルへの書き込みをまとめるバッファの長さ
+    std::size_t buffer_size = 1024 * 1024;
+    // 転送が途中で切断された場合に、続きから再試行する回数
+    unsigned int max_retry = 3;
+    // 既存のファイルを取得した時のETagまたはLast-Modified（If-Rangeとして送信される）
+    std::string_view validator = "";
+  };
+
+  struct parallel_download_config {
+    // 分割数（同時に使用する接続の数）
+    unsigned int parts = 4;
+    // 1つの部分の最小の長さ、これより小さくなる場合は分割数を減らす
+    std::size_t min_part_size = 1024 * 1024;
+    fsync_policy sync = fsync_policy::none;
+    // 部分毎に、ファイルへの書き込みをまとめるバッファの長さ
+    std::size_t buffer_size = 1024 * 1024;
+    // 部分毎に、転送が途中で切断された場合に続きから再試行する回数
+    unsigned int max_retry = 3;
+  };
+
+  struct remote_file_config {
+    // 1回のリクエストで取得する最小の単位
+    std::size_t block_size = 64 * 1024;
+    // キャッシュするブロックの数
+    std::size_t cache_blocks = 64;
+    // 連続した読み込みを検出した場合に、先読みするブロックの数
+    std::size_t readahead_blocks = 4;
+  };
+
+  struct sse_config {
+    // 再接続までの待機時間、サーバーからretryフィールドが送られた場合はそれに従う
+    std::chrono::milliseconds retry{ 3000 };
+    // イベントを1つも受け取れないまま再接続する回数の上限
+    unsigned int max_retry = 5;
+    // 最初の接続時にLast-Event-IDとして送信する値
+    std::string_view last_event_id = "";
+    // この時間受信がない場合は切断されたとみなして再接続する（0の場合は、agentのタイムアウトを接続毎に適用する）
+    std::chrono::milliseconds idle_timeout{ 60000 };
   };
 }
 
@@ -1338,6 +2604,22 @@ namespace chttpp {
   namespace cfg_prxy {
     using enum chttpp::detail::config::enums::proxy_scheme;
   }
+
+  // レスポンスボディ受信コールバックの戻り値
+  using chttpp::detail::config::enums::receive_status;
+
+  // 一時停止された転送の再開ハンドル
+  using chttpp::detail::flow_control;
+
+  // ダウンロードの設定
+  using chttpp::detail::config::enums::fsync_policy;
+
+  // ボディ受信前のレスポンスの検査
+  using chttpp::detail::response_head;
+  using chttpp::detail::body_action;
+
+  // multipart/form-dataのリクエストボディ（chttpp.hppで定義）
+  class multipart;
 }
 
 namespace chttpp::detail {
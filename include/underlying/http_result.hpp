@@ -625,6 +625,8 @@ namespace chttpp::detail {
     vector_t<char> body;
     header_t headers;
     http_status_code status_code;
+    // response_data(std::endian)によってbodyがバイトスワップされている場合の要素サイズ（0なら受信したまま）
+    std::size_t swapped_element_size = 0;
 
 
     auto response_body() const & -> std::string_view {
@@ -646,6 +648,10 @@ namespace chttpp::detail {
 
     template<substantial ElementType>
     auto response_data(std::size_t N = std::dynamic_extent) & -> std::span<ElementType> {
+      static_assert(alignof(ElementType) <= response_body_alignment, "The alignment of ElementType exceeds that of the response body buffer. Define CHTTPP_RESPONSE_BODY_ALIGNMENT to a larger value.");
+      // bodyはmake_response_body()によって確保されていること
+      assert(reinterpret_cast<std::uintptr_t>(data(body)) % alignof(ElementType) == 0);
+
       const std::size_t count = std::min(N, size(body) / sizeof(ElementType));
 
       return { reinterpret_cast<ElementType*>(data(body)), count };
@@ -653,11 +659,51 @@ namespace chttpp::detail {
 
     template<substantial ElementType>
     auto response_data(std::size_t N = std::dynamic_extent) const & -> std::span<const ElementType> {
+      static_assert(alignof(ElementType) <= response_body_alignment, "The alignment of ElementType exceeds that of the response body buffer. Define CHTTPP_RESPONSE_BODY_ALIGNMENT to a larger value.");
+      // bodyはmake_response_body()によって確保されていること
+      assert(reinterpret_cast<std::uintptr_t>(data(body)) % alignof(ElementType) == 0);
+
       const std::size_t count = std::min(N, size(body) / sizeof(ElementType));
 
       return {reinterpret_cast<const ElementType *>(data(body)), count};
     }
 
+    /**
+     * @brief data_endianのバイトオーダーで並んでいる数値列として、実行環境のバイトオーダーへ変換して参照する
+     * @details 変換はbodyに対してその場で行われるが、変換状態を記録しているため、何度呼んでも受信したデータを基準にした同じ結果になる
+     * @details 変換後のbodyは、他の関数（response_body()など）からも変換された状態で見える
+     */
+    template<byte_order_convertible ElementType>
+    auto response_data(std::endian data_endian, std::size_t N = std::dynamic_extent) & -> std::span<ElementType> {
+      const std::size_t required = (data_endian != std::endian::native) ? sizeof(ElementType) : 0;
+
+      if (swapped_element_size != required) {
+        // 以前の変換を元に戻してから、改めて変換する
+        this->restore_byte_order();
+
+        if (required != 0) {
+          byteswap_in_place(this->response_data<ElementType>());
+        }
+        swapped_element_size = required;
+      }
+
+      return this->response_data<ElementType>(N);
+    }
+
+  private:
+
+    void restore_byte_order() noexcept {
+      switch (swapped_element_size) {
+        case 2: byteswap_in_place(this->response_data<std::uint16_t>()); break;
+        case 4: byteswap_in_place(this->response_data<std::uint32_t>()); break;
+        case 8: byteswap_in_place(this->response_data<std::uint64_t>()); break;
+        default: break;
+      }
+      swapped_element_size = 0;
+    }
+
+  public:
+
     auto response_headers() const & -> header_ref {
       return header_ref{&headers};
     }
@@ -774,6 +820,16 @@ namespace chttpp::detail {
       }
     }
 
+    template<byte_order_convertible ElementType>
+    auto response_data(std::endian data_endian, std::size_t N = std::dynamic_extent) & -> std::span<ElementType> {
+      if (*this) {
+        auto& response = std::get<0>(m_outcome);
+        return response.response_data<ElementType>(data_endian, N);
+      } else {
+        return {};
+      }
+    }
+
     auto response_headers() const & -> header_ref {
       // この関数は参照を返すので、失敗時に代わりに返すものがない
       if (*this) {
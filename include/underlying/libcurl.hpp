@@ -13,6 +13,16 @@
 #include <cstdlib>
 #include <unordered_map>
 #include <numeric>
+#include <charconv>
+#include <filesystem>
+#include <system_error>
+
+#include <mutex>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 
 #include <curl/curl.h>
 
@@ -22,6 +32,7 @@ namespace chttpp::underlying {
 
     static constexpr ::CURLcode no_error_value = ::CURLE_OK;
     static constexpr ::CURLcode url_error_value = ::CURLE_URL_MALFORMAT;
+    static constexpr ::CURLcode range_error_value = ::CURLE_RANGE_ERROR;
 
     static auto error_to_string(::CURLcode ec) -> string_t {
       return {curl_easy_strerror(ec)};
@@ -142,48 +153,504 @@ namespace chttpp::underlying {
   using unique_slist = std::unique_ptr<curl_slist, deleter_t<curl_slist, curl_slist_free_all>>;
   using unique_curlurl = std::unique_ptr<CURLU, deleter_t<CURLU, curl_url_cleanup>>;
   using unique_curlchar = std::unique_ptr<char, deleter_t<char, curl_free>>;
+  using unique_curlm = std::unique_ptr<CURLM, deleter_t<CURLM, curl_multi_cleanup>>;
+  using unique_mime = std::unique_ptr<curl_mime, deleter_t<curl_mime, curl_mime_free>>;
+  using unique_curlsh = std::unique_ptr<CURLSH, deleter_t<CURLSH, curl_share_cleanup>>;
 
   inline void unique_slist_append(unique_slist& plist, const char* value) noexcept {
     auto ptr = plist.release();
     plist.reset(curl_slist_append(ptr, value));
   }
 
+#ifndef CHTTPP_DO_NOT_CUSTOMIZE_ALLOCATOR
+
+  /**
+   * @brief 閾値を超える長さの確保を、名前のない一時ファイルをmmapした領域から行うmemory_resource
+   * @details 閾値はspill_scopeによってスレッド毎に指定され、指定のない間は常に上流から確保する
+   * @details 一時ファイルはTMPDIR（なければ/tmp）に作成され、そのファイルから確保した領域が全て解放された時に消える
+   */
+  class spill_memory_resource : public std::pmr::memory_resource {
+
+    /**
+     * @brief 領域を確保した一時ファイル、伸長時には同じファイルを複数の領域が共有する
+     */
+    struct spill_file {
+      int fd = -1;
+      std::size_t size = 0;
+
+      spill_file() = default;
+
+      spill_file(const spill_file&) = delete;
+      spill_file& operator=(const spill_file&) = delete;
+
+      ~spill_file() {
+        if (fd != -1) {
+          ::close(fd);
+        }
+      }
+    };
+
+    std::pmr::memory_resource* m_upstream;
+    // 一時ファイルから確保した領域と、その元のファイル
+    std::mutex m_mutex;
+    std::unordered_map<void*, std::shared_ptr<spill_file>> m_mapped;
+
+    static auto current_threshold() noexcept -> std::size_t& {
+      thread_local std::size_t threshold = 0;
+      return threshold;
+    }
+
+    static auto current_growing() noexcept -> const void*& {
+      thread_local const void* growing = nullptr;
+      return growing;
+    }
+
+    static auto open_tmpfile() -> std::shared_ptr<spill_file> {
+      const char* dir = std::getenv("TMPDIR");
+      if (dir == nullptr or *dir == '\0') {
+        dir = "/tmp";
+      }
+
+      auto file = std::make_shared<spill_file>();
+#ifdef O_TMPFILE
+      file->fd = ::open(dir, O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+#endif
+      if (file->fd < 0) {
+        // O_TMPFILEに対応していない場合、作成してすぐに削除する
+        std::string path{dir};
+        path.append("/chttpp-XXXXXX");
+        file->fd = ::mkstemp(path.data());
+        if (file->fd < 0) {
+          return nullptr;
+        }
+        ::unlink(path.c_str());
+      }
+
+      return file;
+    }
+
+    /**
+     * @brief ファイルを必要なら伸長し、先頭からbytesの長さを対応付ける
+     * @details 他の領域と同じファイルを対応付けた場合、それらは先頭から同じ内容を共有する
+     */
+    static auto map_file(spill_file& file, std::size_t bytes) noexcept -> void* {
+      if (file.size < bytes) {
+        if (::ftruncate(file.fd, static_cast<off_t>(bytes)) != 0) {
+          return nullptr;
+        }
+        file.size = bytes;
+      }
+
+      void* ptr = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, file.fd, 0);
+      return ptr == MAP_FAILED ? nullptr : ptr;
+    }
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+      const std::size_t threshold = current_threshold();
+
+      if (threshold != 0 and threshold < bytes and alignment <= static_cast<std::size_t>(::sysconf(_SC_PAGESIZE))) {
+        std::lock_guard lock{m_mutex};
+
+        // 伸長される領域が一時ファイルにある場合、そのファイルを伸ばして対応付け直す
+        // 新しい領域は元の内容を共有しているため、コンテナによる移動は同じページへの上書きとなり、ファイルも複製されない
+        std::shared_ptr<spill_file> file = nullptr;
+        if (const auto pos = m_mapped.find(const_cast<void*>(current_growing())); pos != m_mapped.end()) {
+          file = (*pos).second;
+        } else {
+          file = open_tmpfile();
+        }
+
+        if (file != nullptr) {
+          if (void* ptr = map_file(*file, bytes); ptr != nullptr) {
+            m_mapped.emplace(ptr, std::move(file));
+            return ptr;
+          }
+        }
+        // 一時ファイルを用意できない場合はメモリから確保する
+      }
+
+      return m_upstream->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override {
+      {
+        std::lock_guard lock{m_mutex};
+        // 最後の領域が解放されるとファイルも閉じられる
+        if (const auto pos = m_mapped.find(ptr); pos != m_mapped.end()) {
+          ::munmap(ptr, bytes);
+          m_mapped.erase(pos);
+          return;
+        }
+      }
+
+      m_upstream->deallocate(ptr, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+      return this == &other;
+    }
+
+  public:
+
+    explicit spill_memory_resource(std::pmr::memory_resource* upstream) noexcept
+      : m_upstream{upstream}
+    {}
+
+    spill_memory_resource(const spill_memory_resource&) = delete;
+    spill_memory_resource& operator=(const spill_memory_resource&) = delete;
+
+    /**
+     * @brief このスコープの間、現在のスレッドで行われる確保に閾値を指定する
+     * @param growing このスコープで伸長される領域（確保はその置き換えとみなされ、一時ファイルにある場合は同じファイルを伸ばして使用する）
+     */
+    class spill_scope {
+      std::size_t m_prev;
+      const void* m_prev_growing;
+
+    public:
+      explicit spill_scope(std::size_t threshold, const void* growing = nullptr) noexcept
+        : m_prev{std::exchange(current_threshold(), threshold)}
+        , m_prev_growing{std::exchange(current_growing(), growing)}
+      {}
+
+      spill_scope(const spill_scope&) = delete;
+      spill_scope& operator=(const spill_scope&) = delete;
+
+      ~spill_scope() {
+        current_threshold() = m_prev;
+        current_growing() = m_prev_growing;
+      }
+    };
+  };
+
+  /**
+   * @brief 一時ファイルへの退避が有効なレスポンスボディの確保に使用するmemory_resourceを取得する
+   */
+  inline auto spill_body_resource() -> spill_memory_resource* {
+    static spill_memory_resource resource{detail::response_body_resource()};
+    return &resource;
+  }
+
+#endif
+
+  /**
+   * @brief リクエストボディとして、メモリ上のバイト列をそのまま送信する
+   */
+  inline void set_request_body(CURL* session, std::span<const char> req_body) {
+    curl_easy_setopt(session, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(req_body.size()));
+    curl_easy_setopt(session, CURLOPT_POSTFIELDS, const_cast<char *>(req_body.data()));
+  }
+
+  /**
+   * @brief CURLOPT_READFUNCTIONに指定し、body_readerからリクエストボディを読み出す
+   */
+  inline auto read_request_body(char* buffer, std::size_t size, std::size_t nitems, void* reader_ptr) -> std::size_t {
+    auto& reader = *static_cast<detail::body_reader*>(reader_ptr);
+    const std::size_t buffer_len = size * nitems;
+
+    try {
+      const std::size_t read_len = reader.read({buffer, buffer_len});
+
+      if (buffer_len < read_len) {
+        return CURL_READFUNC_ABORT;
+      }
+
+      return read_len;
+    } catch (...) {
+      // 例外はlibcurlを超えて伝播させられないので、転送を中断する
+      return CURL_READFUNC_ABORT;
+    }
+  }
+
+  /**
+   * @brief CURLOPT_SEEKFUNCTIONに指定し、再送信のためにbody_readerの読み出し位置を戻す
+   * @details libcurlはリダイレクト（307/308）や認証のやり直しの際に、先頭からの位置でシークする
+   */
+  inline auto seek_request_body(void* reader_ptr, curl_off_t offset, int origin) -> int {
+    auto& reader = *static_cast<detail::body_reader*>(reader_ptr);
+
+    if (origin != SEEK_SET or offset < 0 or not reader.can_seek()) {
+      return CURL_SEEKFUNC_CANTSEEK;
+    }
+
+    try {
+      return reader.seek(static_cast<std::size_t>(offset)) ? CURL_SEEKFUNC_OK : CURL_SEEKFUNC_FAIL;
+    } catch (...) {
+      return CURL_SEEKFUNC_FAIL;
+    }
+  }
+
+  /**
+   * @brief リクエストボディとして、body_readerから逐次読み出したデータを送信する
+   * @details 長さが不明な場合、POSTFIELDSIZEに-1を指定することでチャンク形式で送信される（HTTP/1.1の場合）
+   * @details readerがシークできない場合、再送信が必要になるとCURLE_SEND_FAIL_REWINDで失敗する
+   */
+  inline void set_request_body(CURL* session, detail::body_reader& reader) {
+    // 読み出しのブロックサイズ（セッションは使いまわされるので、指定がなくてもデフォルト値を設定し直す）
+    constexpr long default_upload_buffer_size = 65536;
+    constexpr long max_upload_buffer_size = 2 * 1024 * 1024;
+    const long block_size = reader.block_size() == 0 ? default_upload_buffer_size : static_cast<long>(std::min<std::size_t>(reader.block_size(), max_upload_buffer_size));
+    curl_easy_setopt(session, CURLOPT_UPLOAD_BUFFERSIZE, block_size);
+
+    if (const auto data = reader.contiguous(); data.data() != nullptr) {
+      // メモリ上に連続している場合はコピーせずにそのまま送信する
+      set_request_body(session, data);
+      return;
+    }
+
+    // POSTFIELDSをクリアしてから、POSTを指定すると読み出しコールバックが使用される
+    curl_easy_setopt(session, CURLOPT_POSTFIELDS, nullptr);
+    curl_easy_setopt(session, CURLOPT_POST, 1L);
+    curl_easy_setopt(session, CURLOPT_READFUNCTION, read_request_body);
+    curl_easy_setopt(session, CURLOPT_READDATA, &reader);
+    curl_easy_setopt(session, CURLOPT_SEEKFUNCTION, seek_request_body);
+    curl_easy_setopt(session, CURLOPT_SEEKDATA, &reader);
+
+    const curl_off_t length = reader.has_length() ? static_cast<curl_off_t>(reader.length()) : -1;
+    curl_easy_setopt(session, CURLOPT_POSTFIELDSIZE_LARGE, length);
+  }
+
+  /**
+   * @brief リクエストボディの送信に使用したコールバックとデータへの参照を、セッションから外す
+   * @details agentのセッションは使いまわされるため、転送後に破棄されたbody_readerやバッファを指したままにしない
+   */
+  inline void reset_request_body(CURL* session, unique_mime& mime_holder) {
+    curl_easy_setopt(session, CURLOPT_READFUNCTION, nullptr);
+    curl_easy_setopt(session, CURLOPT_READDATA, nullptr);
+    curl_easy_setopt(session, CURLOPT_SEEKFUNCTION, nullptr);
+    curl_easy_setopt(session, CURLOPT_SEEKDATA, nullptr);
+    curl_easy_setopt(session, CURLOPT_POSTFIELDS, nullptr);
+    curl_easy_setopt(session, CURLOPT_MIMEPOST, nullptr);
+    mime_holder.reset();
+  }
+
+  /**
+   * @brief メモリ上のデータをmultipartのパートとして読み出す位置
+   */
+  struct mime_span_cursor {
+    std::span<const char> data;
+    std::size_t pos = 0;
+
+    static auto read(char* buffer, std::size_t size, std::size_t nitems, void* arg) -> std::size_t {
+      auto& self = *static_cast<mime_span_cursor*>(arg);
+      const std::size_t len = std::min(size * nitems, self.data.size() - self.pos);
+
+      std::memcpy(buffer, self.data.data() + self.pos, len);
+      self.pos += len;
+
+      return len;
+    }
+
+    static auto seek(void* arg, curl_off_t offset, int origin) -> int {
+      auto& self = *static_cast<mime_span_cursor*>(arg);
+
+      // libcurlは先頭からの位置でのみシークする（リダイレクトや認証による再送時）
+      if (origin != SEEK_SET or offset < 0 or self.data.size() < static_cast<std::size_t>(offset)) {
+        return CURL_SEEKFUNC_CANTSEEK;
+      }
+
+      self.pos = static_cast<std::size_t>(offset);
+      return CURL_SEEKFUNC_OK;
+    }
+
+    static void destroy(void* arg) {
+      delete static_cast<mime_span_cursor*>(arg);
+    }
+  };
+
+  /**
+   * @brief リクエストボディとして、multipartの各パートからcurl_mimeを構築して送信する
+   * @details 各パートのデータは転送中に読み出され、ボディ全体を連結したバッファは作成しない
+   * @details 構築したcurl_mimeは転送の完了まで生存している必要があるため、holderに保持する
+   */
+  template<std::same_as<::chttpp::multipart> Form>
+  auto set_request_body(CURL* session, Form& form, unique_mime& holder) -> CURLcode {
+    unique_mime mime{curl_mime_init(session)};
+
+    if (not mime) {
+      return CURLE_OUT_OF_MEMORY;
+    }
+
+    for (auto& part : form.parts()) {
+      curl_mimepart* mpart = curl_mime_addpart(mime.get());
+
+      if (mpart == nullptr) {
+        return CURLE_OUT_OF_MEMORY;
+      }
+
+      const CURLcode data_ec = std::visit([mpart]<typename S>(S& source) -> CURLcode {
+        if constexpr (std::same_as<S, std::span<const char>>) {
+          // コピーせずに、転送中に元の領域から読み出す
+          std::unique_ptr<mime_span_cursor> cursor{new mime_span_cursor{source}};
+          const CURLcode ec = curl_mime_data_cb(mpart, static_cast<curl_off_t>(source.size()), mime_span_cursor::read, mime_span_cursor::seek, mime_span_cursor::destroy, cursor.get());
+          if (ec == CURLE_OK) {
+            // 以降はcurl_mimeが所有する
+            cursor.release();
+          }
+          return ec;
+        } else if constexpr (std::same_as<S, std::filesystem::path>) {
+          // ファイル名は指定がなければパスのファイル名になる
+          return curl_mime_filedata(mpart, source.c_str());
+        } else {
+          const curl_off_t length = source.has_length() ? static_cast<curl_off_t>(source.length()) : -1;
+          return curl_mime_data_cb(mpart, length, read_request_body, seek_request_body, nullptr, &source);
+        }
+      }, part.source);
+
+      if (data_ec != CURLE_OK) {
+        return data_ec;
+      }
+
+      if (const CURLcode ec = curl_mime_name(mpart, part.name.c_str()); ec != CURLE_OK) {
+        return ec;
+      }
+
+      if (not part.filename.empty()) {
+        if (const CURLcode ec = curl_mime_filename(mpart, part.filename.c_str()); ec != CURLE_OK) {
+          return ec;
+        }
+      }
+
+      if (not part.content_type.empty()) {
+        if (const CURLcode ec = curl_mime_type(mpart, part.content_type.c_str()); ec != CURLE_OK) {
+          return ec;
+        }
+      }
+    }
+
+    // Content-Typeヘッダのboundaryパラメータはlibcurlが付加する
+    curl_easy_setopt(session, CURLOPT_MIMEPOST, mime.get());
+    holder = std::move(mime);
+
+    return CURLE_OK;
+  }
+
+  /**
+   * @brief receive_statusを、libcurlの書き込みコールバックの戻り値に変換する
+   */
+  inline constexpr auto to_write_result(receive_status status, std::size_t data_len) noexcept -> std::size_t {
+    switch (status) {
+      case receive_status::abort:
+        // data_len以外を返すと、CURLE_WRITE_ERRORで転送が中断される
+        return 0;
+      case receive_status::pause:
+        // 再開後、同じデータで再度呼ばれる
+        return CURL_WRITEFUNC_PAUSE;
+      default:
+        return data_len;
+    }
+  }
+
+  /**
+   * @brief 一時停止中に再開要求を確認する間隔（ミリ秒）
+   */
+  inline constexpr int resume_check_interval_ms = 10;
+
+  /**
+   * @brief 受信コールバックによって一時停止されうる転送を、multiインターフェースで実行する
+   * @details curl_easy_perform()は一時停止中に最長1秒程度待機してしまうため、自前でループを回して再開要求を短い間隔で確認する
+   * @details flowがnullptrの場合、一時停止は次のループで即座に再開される
+   * @details 接続はセッションに設定された共有ハンドルが保持するため、curl_easy_perform()による転送と同じ接続を再利用できる
+   */
+  inline auto perform_pausable(CURL* handle, unique_curlm& multi, detail::flow_control* flow) -> CURLcode {
+    if (not multi) {
+      // 初回のみ初期化し、以降は使いまわす
+      multi.reset(curl_multi_init());
+
+      if (not multi) {
+        return CURLE_FAILED_INIT;
+      }
+    }
+
+    if (curl_multi_add_handle(multi.get(), handle) != CURLM_OK) {
+      return CURLE_FAILED_INIT;
+    }
+
+    CURLcode result = CURLE_OK;
+
+    for (int running = 1; 0 < running;) {
+      if (curl_multi_perform(multi.get(), &running) != CURLM_OK) {
+        result = CURLE_FAILED_INIT;
+        break;
+      }
+
+      if (running == 0) break;
+
+      // 再開要求の確認（一時停止されていない場合のcurl_easy_pause()は何もしない）
+      if (flow == nullptr or flow->consume_resume()) {
+        curl_easy_pause(handle, CURLPAUSE_CONT);
+      }
+
+      // 通信がない場合でも、一定間隔で再開要求を確認する
+      if (curl_multi_poll(multi.get(), nullptr, 0, resume_check_interval_ms, nullptr) != CURLM_OK) {
+        result = CURLE_FAILED_INIT;
+        break;
+      }
+    }
+
+    // 転送結果の取得
+    int remain = 0;
+    while (CURLMsg* msg = curl_multi_info_read(multi.get(), &remain)) {
+      if (msg->msg == CURLMSG_DONE and msg->easy_handle == handle) {
+        result = msg->data.result;
+      }
+    }
+
+    curl_multi_remove_handle(multi.get(), handle);
+
+    return result;
+  }
+
   template<typename T, std::invocable<T&, char*, std::size_t> auto receiver>
   auto write_callback(char* data_ptr, std::size_t one, std::size_t length, void* buffer_ptr) -> std::size_t {
     auto& buffer_obj = *reinterpret_cast<T*>(buffer_ptr);
     const std::size_t data_len = one * length;  // 第二引数(one)は常に1
 
-    receiver(buffer_obj, data_ptr, data_len);
+    if constexpr (std::same_as<std::invoke_result_t<decltype(receiver), T&, char*, std::size_t>, std::size_t>) {
+      // 受信側の返す値をそのまま返す（data_len以外は失敗扱い）
+      return receiver(buffer_obj, data_ptr, data_len);
+    } else {
+      receiver(buffer_obj, data_ptr, data_len);
 
-    // 返さないと失敗扱い
-    return data_len;
+      // 返さないと失敗扱い
+      return data_len;
+    }
   }
 
-  inline auto rebuild_url(CURLU* hurl, const vector_t<std::pair<std::string_view, std::string_view>>& params, string_buffer& buffer) -> char* {
-    for (const auto& p : params) {
-      buffer.use([&](auto& param_buf) {
-        // name=value の形にしてから追記
-        param_buf.append(p.first);
-        param_buf.append("=");
-        param_buf.append(p.second);
-
-        // URLエンコード（=を除く）と&付加はしてくれる
-        curl_url_set(hurl, CURLUPART_QUERY, param_buf.c_str(), CURLU_APPENDQUERY | CURLU_URLENCODE);
-      });
+  /**
+   * @brief 指定されたURLパラメータを付加したURLを構成する
+   * @details URLの検証と正規化のみlibcurlのURL APIで行い、パラメータはまとめてエンコードしてurlへ追記する
+   * @details （CURLU_APPENDQUERYによるパラメータ毎の追加は、その度にクエリの再解析と再確保が発生する）
+   */
+  inline bool rebuild_url(CURLU* hurl, const vector_t<std::pair<std::string_view, std::string_view>>& params, string_t& url) {
+    char *purl = nullptr;
+    // 検証済みのURLの取得
+    if (curl_url_get(hurl, CURLUPART_URL, &purl, 0) != CURLUcode::CURLUE_OK) {
+      return false;
     }
 
-    // アンカーの削除（これはブラウザでのみ意味があり通常リクエストの一部ではない）
-    curl_url_set(hurl, CURLUPART_FRAGMENT, nullptr, 0);
+    unique_curlchar url_holder{purl};
 
-    char *purl = nullptr;
-    // 編集後urlの取得
-    const auto res = curl_url_get(hurl, CURLUPART_URL, &purl, 0);
-    
-    if (res != CURLUcode::CURLUE_OK) {
-      return nullptr;
-    }
+    url.append(purl);
+    // アンカーの削除も行われる（これはブラウザでのみ意味があり通常リクエストの一部ではない）
+    detail::append_query_params(url, params);
+
+    return true;
+  }
+
+  /**
+   * @brief 指定されたURLパラメータを付加したURLを、リクエストURLとして設定する
+   */
+  inline auto set_request_url(CURL* session, CURLU* hurl, const vector_t<std::pair<std::string_view, std::string_view>>& params, string_buffer& buffer) -> CURLcode {
+    return buffer.use([&](string_t& url) {
+      if (not rebuild_url(hurl, params, url)) {
+        // エラーコードの変換については要検討
+        return CURLE_URL_MALFORMAT;
+      }
 
-    return purl;
+      // URLの文字列はlibcurlがコピーする
+      return curl_easy_setopt(session, CURLOPT_URL, url.c_str());
+    });
   }
 
   inline void common_proxy_setting(CURL* session, const detail::proxy_config& prxy_cfg) {
@@ -284,6 +751,9 @@ namespace chttpp::underlying {
     unique_curlchar userptr = nullptr;
     unique_curlchar pwptr = nullptr;
 
+    // multipart/form-dataのリクエストボディ、次のリクエストまで保持する
+    unique_mime mime_body = nullptr;
+
     libcurl_session_state() = default;
 
     auto init(std::string_view url, const detail::config::proxy_config& prxy_cfg, std::chrono::milliseconds timeout, cfg::http_version version) & -> detail::error_code {
@@ -397,7 +867,7 @@ namespace chttpp::underlying::terse {
   using namespace chttpp::underlying;
 
   template<typename MethodTag>
-  auto request_impl(libcurl_session_state&& state, auto&& cfg, [[maybe_unused]] std::span<const char> req_body, MethodTag) -> http_result {
+  auto request_impl(libcurl_session_state&& state, auto&& cfg, [[maybe_unused]] auto&& req_body, MethodTag) -> http_result {
     // メソッドタイプ判定
     constexpr bool has_request_body = detail::tag::has_reqbody_method<MethodTag>;
 
@@ -425,18 +895,12 @@ namespace chttpp::underlying::terse {
       curl_easy_setopt(session.get(), CURLOPT_PASSWORD, const_cast<char *>(cfg.auth.password.data()));
     }
 
-    // 指定されたURLパラメータを含むようにURLを編集、その先頭ポインタを得る
-    unique_curlchar purl{rebuild_url(hurl.get(), cfg.params, buffer)};
-
-    if (purl == nullptr) {
-      // エラーコードの変換については要検討
-      return http_result{CURLcode::CURLE_URL_MALFORMAT};
+    // 指定されたURLパラメータを含むようにURLを構成してセット
+    if (const CURLcode ec = set_request_url(session.get(), hurl.get(), cfg.params, buffer); ec != CURLE_OK) {
+      return http_result{ec};
     }
 
-    // URLのセット
-    curl_easy_setopt(session.get(), CURLOPT_URL, purl.get());
-
-    vector_t<char> body{};
+    auto body = detail::make_response_body();
     header_t headers;
 
     curl_easy_setopt(session.get(), CURLOPT_ACCEPT_ENCODING, "");
@@ -445,8 +909,13 @@ namespace chttpp::underlying::terse {
 
     if constexpr (has_request_body) {
 
-      curl_easy_setopt(session.get(), CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(req_body.size()));
-      curl_easy_setopt(session.get(), CURLOPT_POSTFIELDS, const_cast<char *>(req_body.data()));
+      if constexpr (std::same_as<std::remove_cvref_t<decltype(req_body)>, ::chttpp::multipart>) {
+        if (const CURLcode ec = set_request_body(session.get(), req_body, state.mime_body); ec != CURLE_OK) {
+          return http_result{ec};
+        }
+      } else {
+        set_request_body(session.get(), req_body);
+      }
 
       if constexpr (is_put) {
         curl_easy_setopt(session.get(), CURLOPT_CUSTOMREQUEST, "PUT");
@@ -512,8 +981,8 @@ namespace chttpp::underlying::terse {
     // レスポンスボディコールバックの指定
     if constexpr (has_request_body or is_get or is_opt) { 
       auto* body_recieve = write_callback<decltype(body), [](decltype(body)& buffer, char* data_ptr, std::size_t data_len) {
-        buffer.reserve(buffer.size() + data_len);
-        std::ranges::copy(data_ptr, data_ptr + data_len, std::back_inserter(buffer));
+        // 毎回ぴったりのreserve()をすると再確保が頻発するので、insert()に伸長を任せる
+        buffer.insert(buffer.end(), data_ptr, data_ptr + data_len);
       }>;
       curl_easy_setopt(session.get(), CURLOPT_WRITEFUNCTION, body_recieve);
       curl_easy_setopt(session.get(), CURLOPT_WRITEDATA, &body);
@@ -579,6 +1048,16 @@ namespace chttpp::underlying::agent_impl {
     using type = detail::string_buffer;
   };
 
+  /**
+   * @brief tail()で取得中のリソース毎の状態
+   */
+  struct tail_state {
+    // 次に要求する位置（取得済みの長さ）
+    std::uint64_t offset = 0;
+    // 取得済みの部分のETagまたはLast-Modified
+    string_t validator{};
+  };
+
   struct agent_resource {
     // コンストラクタで渡す設定
     detail::agent_initial_config config;
@@ -591,16 +1070,28 @@ namespace chttpp::underlying::agent_impl {
     chttpp::follow_redirects follow_redirect;
     chttpp::automatic_decompression auto_decomp;
 
+    // curl_easy_perform()とmultiハンドルによる転送とで共有する接続キャッシュ（必要になった時に初期化される）
+    // セッションから参照されるため、セッションよりも後に破棄されるようにここに置く
+    unique_curlsh share = nullptr;
+
     // agentの状態詳細（agentでしか使わないバッファなどはsession_stateに置かないようにする）
     libcurl_session_state state{};
     // URLからコンポーネント情報などを抽出する（ほぼクッキーのため）
     detail::url_info request_url;
     // vector_t<detail::cookie_ref> cookie_buf{};
     detail::vector_buffer<detail::cookie_ref> cookie_buf{};
+    // 一時停止されうる転送の実行に使用する（必要になった時に初期化される）
+    unique_curlm multi = nullptr;
+    // tail()で取得中のリソースの状態（パス毎）
+    umap_t<string_t, tail_state, string_hash> tail_states{};
   };
 
+  /**
+   * @brief agentのセッションに対して、リクエストの送信に必要な設定を行う
+   * @details 送信ヘッダのリストは転送の完了まで生存している必要があるため、呼び出し側で保持する
+   */
   template<typename MethodTag>
-  inline auto request_impl(std::string_view url_path, agent_resource& resource, detail::agent_request_config&& req_cfg, [[maybe_unused]] std::span<const char> req_body, MethodTag) -> http_result {
+  auto prepare_request(const detail::url_path_ref& url_path, agent_resource& resource, const detail::agent_request_config& req_cfg, [[maybe_unused]] auto&& req_body, MethodTag, unique_slist& req_header_list) -> CURLcode {
     // メソッドタイプ判定
     constexpr bool has_request_body = detail::tag::has_reqbody_method<MethodTag>;
 
@@ -618,6 +1109,16 @@ namespace chttpp::underlying::agent_impl {
     auto& state = resource.state;
     auto& session = state.session;
 
+    if (not resource.share) {
+      // 受信コールバックによる一時停止のためにmultiハンドルで転送する場合も、接続を再利用できるようにする
+      resource.share.reset(curl_share_init());
+      if (not resource.share) {
+        return CURLE_FAILED_INIT;
+      }
+      curl_share_setopt(resource.share.get(), CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+      curl_easy_setopt(session.get(), CURLOPT_SHARE, resource.share.get());
+    }
+
     // 認証情報の取得とセット、configに指定された方を優先する
     // 以前に設定されていて、後のリクエストで認証情報が削除された場合、curl_easy_reset()を呼び出さないと認証情報をクリアできない
     // あるいは、送信ヘッダから削除するという方法があるらしいが・・・
@@ -629,33 +1130,17 @@ namespace chttpp::underlying::agent_impl {
       curl_easy_setopt(session.get(), CURLOPT_PASSWORD, const_cast<char *>(req_cfg.auth.password.data()));
     }
 
-    // URL末尾に追加部分を付加
+    // URL末尾に追加部分とURLパラメータを付加
     // この関数の実行中はURLを維持する
+    // url_infoはURLを解析済みなので、libcurlのURL APIによる再解析と再構成は行わない
     [[maybe_unused]]
-    auto pinning_fullurl = resource.request_url.append_path(url_path);
-
-    // 同じcurluステートを使い回してメモリ確保回避を期待（なってるんかな
-    auto &hurl = state.hurl;
-
-    // URLの読み込み
-    // クエリが事前に存在する場合などのハンドルが面倒なので、毎回URLをセットし直す
-    if (auto ec = curl_url_set(hurl.get(), CURLUPART_URL, resource.request_url.full_url().data(), 0); ec != CURLUE_OK) {
-      // エラーコード要検討
-      return http_result{CURLcode::CURLE_URL_MALFORMAT};
-    }
-
-    // 指定されたURLパラメータを含むようにURLを編集、その先頭ポインタを得る
-    unique_curlchar purl{rebuild_url(hurl.get(), req_cfg.params, state.buffer)};
-
-    if (purl == nullptr) {
-      // エラーコードの変換については要検討
-      return http_result{CURLcode::CURLE_URL_MALFORMAT};
-    }
+    auto pinning_fullurl = resource.request_url.append_path(url_path, req_cfg.params);
 
-    // フルに構成したURLをセット
-    curl_easy_setopt(session.get(), CURLOPT_URL, purl.get());
+    // フルに構成したURLをセット（URLの文字列はlibcurlがコピーする）
+    curl_easy_setopt(session.get(), CURLOPT_URL, resource.request_url.full_url().data());
 
-    if (resource.auto_decomp.enabled()) {
+    // Rangeやサイズを圧縮前の表現に対して扱うリクエスト（ダウンロードなど）では、圧縮を要求しない
+    if (resource.auto_decomp.enabled() and not req_cfg.identity_encoding) {
       // この指定はlibcurlが対応する全ての圧縮を自動解凍する指定
       // ヘッダで指定された場合はそちらが送信される
       // その場合、自動解凍はされる？（ChatGPTはされるって言ってる）
@@ -667,6 +1152,13 @@ namespace chttpp::underlying::agent_impl {
 
     curl_easy_setopt(session.get(), CURLOPT_USERAGENT, detail::default_UA.data());
 
+    // ボディの長さの上限は、メモリへ受信する場合にのみ設定する（ファイルやストリームへの受信では無制限）
+    curl_easy_setopt(session.get(), CURLOPT_MAXFILESIZE_LARGE, curl_off_t{0});
+
+    // 受信が途絶えた時間で判定する場合、転送全体のタイムアウトは適用しない
+    curl_easy_setopt(session.get(), CURLOPT_TIMEOUT_MS, req_cfg.idle_timeout.count() != 0 ? 0L : static_cast<long>(resource.config.timeout.count()));
+    curl_easy_setopt(session.get(), CURLOPT_NOPROGRESS, 1L);
+
     if (resource.follow_redirect.enabled()) {
       curl_easy_setopt(session.get(), CURLOPT_FOLLOWLOCATION, 1L);
     } else {
@@ -675,8 +1167,13 @@ namespace chttpp::underlying::agent_impl {
 
     if constexpr (has_request_body) {
 
-      curl_easy_setopt(session.get(), CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(req_body.size()));
-      curl_easy_setopt(session.get(), CURLOPT_POSTFIELDS, const_cast<char *>(req_body.data()));
+      if constexpr (std::same_as<std::remove_cvref_t<decltype(req_body)>, ::chttpp::multipart>) {
+        if (const CURLcode ec = set_request_body(session.get(), req_body, state.mime_body); ec != CURLE_OK) {
+          return ec;
+        }
+      } else {
+        set_request_body(session.get(), req_body);
+      }
 
       if constexpr (is_put) {
         curl_easy_setopt(session.get(), CURLOPT_CUSTOMREQUEST, "PUT");
@@ -700,7 +1197,6 @@ namespace chttpp::underlying::agent_impl {
       }
     }
 
-    unique_slist req_header_list{};
     {
       constexpr std::string_view separater = ": ";
 
@@ -785,59 +1281,1352 @@ namespace chttpp::underlying::agent_impl {
       });
 
       if (cookie_ec != CURLcode::CURLE_OK) {
-        return http_result{cookie_ec};
+        return cookie_ec;
       }
     }
 
-    vector_t<char> body{};
-    header_t headers;
+    return CURLE_OK;
+  }
 
-    // レスポンスボディコールバックの指定
-    if constexpr (has_request_body or is_get or is_opt) {
-      if (req_cfg.streaming_receiver) {
-        // カスタムのコールバックによる応答本文受け取り
-        auto* body_recieve = write_callback<decltype(req_cfg.streaming_receiver), [](decltype(req_cfg.streaming_receiver)& callback, char* data_ptr, std::size_t data_len) {
-          callback(std::span<const char>{data_ptr, data_len});
-        }>;
-        curl_easy_setopt(session.get(), CURLOPT_WRITEFUNCTION, body_recieve);
-        curl_easy_setopt(session.get(), CURLOPT_WRITEDATA, &req_cfg.streaming_receiver);
-      } else {
-        // デフォルトのコールバック
-        auto* body_recieve = write_callback<decltype(body), [](decltype(body)& buffer, char* data_ptr, std::size_t data_len) {
-          buffer.reserve(buffer.size() + data_len);
-          std::ranges::copy(data_ptr, data_ptr + data_len, std::back_inserter(buffer));
-        }>;
-        curl_easy_setopt(session.get(), CURLOPT_WRITEFUNCTION, body_recieve);
-        curl_easy_setopt(session.get(), CURLOPT_WRITEDATA, &body);
+  /**
+   * @brief 所有するファイルディスクリプタを閉じる
+   */
+  struct unique_fd {
+    int fd = -1;
+
+    unique_fd() = default;
+
+    unique_fd(const unique_fd&) = delete;
+    unique_fd& operator=(const unique_fd&) = delete;
+
+    ~unique_fd() {
+      if (fd != -1) {
+        ::close(fd);
       }
     }
+  };
 
-    // レスポンスヘッダコールバックの指定
-    auto* header_recieve = write_callback<decltype(headers), chttpp::detail::parse_response_header_on_curl>;
-    curl_easy_setopt(session.get(), CURLOPT_HEADERFUNCTION, header_recieve);
-    curl_easy_setopt(session.get(), CURLOPT_HEADERDATA, &headers);
+  /**
+   * @brief レスポンスボディをメモリ（または一時ファイル）へ受信する、デフォルトの受信先
+   */
+  struct body_buffer_sink {
+    vector_t<char> body;
+    CURL* handle;
+    detail::body_budget budget;
+    bool started = false;
+    // 上限を超えたために受信を中断した
+    bool exceeded = false;
+    // response_inspectorによって指定された受信先
+    detail::body_action::kind mode = detail::body_action::kind::keep;
+    // mode == fileの場合の書き込み先
+    unique_fd file{};
+    // ファイル操作で発生したエラー（errno）
+    int error = 0;
+
+    /**
+     * @brief response_inspectorの指示に従って受信先を切り替える
+     * @return 転送を継続するか
+     */
+    bool apply(const detail::body_action& action) {
+      mode = action.action();
+
+      switch (mode) {
+        case detail::body_action::kind::abort:
+          return false;
+        case detail::body_action::kind::keep:
+          if (action.reserve() != 0) {
+#ifndef CHTTPP_DO_NOT_CUSTOMIZE_ALLOCATOR
+            spill_memory_resource::spill_scope scope{budget.spill_threshold};
+#endif
+            body.reserve(action.reserve());
+          }
+          return true;
+        case detail::body_action::kind::file:
+          file.fd = ::open(action.path().c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+          if (file.fd < 0) {
+            error = errno;
+            return false;
+          }
+          return true;
+        default:
+          return true;
+      }
+    }
 
-    const CURLcode curl_status = curl_easy_perform(session.get());
+    /**
+     * @brief 全て書き込むまでwrite()を繰り返す
+     */
+    bool write_all(const char* data_ptr, std::size_t data_len) {
+      while (data_len != 0) {
+        const auto len = ::write(file.fd, data_ptr, data_len);
+        if (len < 0) {
+          if (errno == EINTR) continue;
+          error = errno;
+          return false;
+        }
+        data_ptr += len;
+        data_len -= static_cast<std::size_t>(len);
+      }
+      return true;
+    }
 
-    if (curl_status != CURLE_OK) {
-      return http_result{curl_status};
+    /**
+     * @brief 退避の指定に応じたバッファを作成する
+     */
+    static auto make_body([[maybe_unused]] const detail::body_budget& budget) -> vector_t<char> {
+#ifndef CHTTPP_DO_NOT_CUSTOMIZE_ALLOCATOR
+      if (budget.spill_threshold != 0) {
+        return vector_t<char>{spill_body_resource()};
+      }
+#endif
+      return detail::make_response_body();
     }
 
-    long http_status;
-    curl_easy_getinfo(session.get(), CURLINFO_RESPONSE_CODE, &http_status);
+    static auto on_receive(body_buffer_sink& self, char* data_ptr, std::size_t data_len) -> std::size_t {
+      if (self.mode == detail::body_action::kind::discard) {
+        return data_len;
+      }
+      if (self.mode == detail::body_action::kind::file) {
+        return self.write_all(data_ptr, data_len) ? data_len : 0;
+      }
 
-    if (resource.cookie_management.enabled()) {
-      // サーバからのクッキーを保存する（あれば
-      if (const auto pos = headers.find("set-cookie"); pos != headers.end()) {
-        resource.cookie_vault.insert_from_set_cookie((*pos).second, resource.request_url.host());
+      const auto max_size = self.budget.max_body_size;
+
+      // Content-Lengthのないレスポンスの場合は、ここで上限を確認する
+      if (max_size != 0 and max_size - self.body.size() < data_len) {
+        self.exceeded = true;
+        return 0;
+      }
+
+#ifndef CHTTPP_DO_NOT_CUSTOMIZE_ALLOCATOR
+      // このスコープでの確保は、閾値を超えると一時ファイルから行われる
+      // 一時ファイルに退避済みの場合、伸長は同じファイルを伸ばして行われる
+      spill_memory_resource::spill_scope scope{self.budget.spill_threshold, self.body.data()};
+#endif
+
+      if (not self.started) {
+        self.started = true;
+
+        if (max_size != 0 or self.budget.spill_threshold != 0) {
+          // 上限か退避の指定がある場合、Content-Lengthの分を最初に1度だけ確保する（退避する場合は最初から全体を一時ファイルに置く）
+          curl_off_t content_length = -1;
+          curl_easy_getinfo(self.handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &content_length);
+
+          if (0 < content_length and (max_size == 0 or static_cast<std::size_t>(content_length) <= max_size)) {
+            self.body.reserve(static_cast<std::size_t>(content_length));
+          }
+        }
       }
+
+      // 毎回ぴったりのreserve()をすると再確保が頻発するので、insert()に伸長を任せる
+      self.body.insert(self.body.end(), data_ptr, data_ptr + data_len);
+
+      return data_len;
     }
+  };
 
-    return http_result{chttpp::detail::http_response{ {}, std::move(body), std::move(headers), detail::http_status_code{http_status} }};
+  /**
+   * @brief レスポンスヘッダの受信先、ヘッダの終端でresponse_inspectorを呼び出す
+   * @details リダイレクトや1xx、認証によって複数のレスポンスを受信した場合、headersには最後のレスポンスのヘッダのみが残る
+   */
+  struct response_header_sink {
+    header_t& headers;
+    CURL* handle;
+    detail::response_inspector& inspector;
+    // デフォルトの受信先を使用しない場合はnullptr
+    body_buffer_sink* body;
+    bool follow_redirect;
+    // response_inspectorの指示によって中断した
+    bool aborted = false;
+    std::exception_ptr exception = nullptr;
+    // 最後のレスポンスより前のレスポンスで受信したSet-Cookie（"; "区切り）
+    string_t previous_cookies{};
+
+    static auto on_receive(response_header_sink& self, char* data_ptr, std::size_t data_len) -> std::size_t {
+      if (std::string_view{data_ptr, data_len}.starts_with("HTTP/")) {
+        // 新しいレスポンスの開始、前のレスポンスのヘッダは残さない（クッキーは保存のために取っておく）
+        if (const auto pos = self.headers.find("set-cookie"); pos != self.headers.end()) {
+          if (not self.previous_cookies.empty()) {
+            self.previous_cookies.append("; ");
+          }
+          self.previous_cookies.append((*pos).second);
+        }
+        self.headers.clear();
+      }
+
+      chttpp::detail::parse_response_header_on_curl(self.headers, data_ptr, data_len);
+
+      // ヘッダの終端は空行
+      if (not self.inspector or std::string_view{data_ptr, data_len}.find_first_not_of("\r\n") != std::string_view::npos) {
+        return data_len;
+      }
+
+      long http_status = 0;
+      curl_easy_getinfo(self.handle, CURLINFO_RESPONSE_CODE, &http_status);
+
+      // 1xxの後には最終的なレスポンスが続く
+      if (http_status < 200) {
+        return data_len;
+      }
+
+      // 追従するリダイレクトのボディは受信されない（Locationはこのレスポンスのもの）
+      if (self.follow_redirect and 300 <= http_status and http_status < 400 and http_status != 304 and self.headers.contains("location")) {
+        return data_len;
+      }
+
+      curl_off_t content_length = -1;
+      curl_easy_getinfo(self.handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &content_length);
+
+      char* content_type = nullptr;
+      curl_easy_getinfo(self.handle, CURLINFO_CONTENT_TYPE, &content_type);
+
+      const detail::response_head head{
+        .status = static_cast<std::uint16_t>(http_status),
+        .content_length = 0 <= content_length ? std::optional<std::uint64_t>{static_cast<std::uint64_t>(content_length)} : std::nullopt,
+        .content_type = content_type != nullptr ? std::string_view{content_type} : std::string_view{},
+        .headers = &self.headers
+      };
+
+      try {
+        const auto action = self.inspector(head);
+
+        if (self.body != nullptr) {
+          if (self.body->apply(action)) {
+            return data_len;
+          }
+        } else if (action.action() != detail::body_action::kind::abort) {
+          // 受信コールバックが指定されている場合、中断以外の指示は意味を持たない
+          return data_len;
+        }
+      } catch (...) {
+        self.exception = std::current_exception();
+      }
+
+      self.aborted = true;
+      return 0;
+    }
+  };
+
+  /**
+   * @brief 受信が途絶えている時間を監視し、指定時間を超えたら転送を中断する
+   * @details 進捗コールバックは受信がない間も定期的に呼ばれる
+   */
+  struct idle_watcher {
+    std::chrono::milliseconds timeout;
+    curl_off_t received = 0;
+    std::chrono::steady_clock::time_point last_received = std::chrono::steady_clock::now();
+    // タイムアウトによって中断した
+    bool expired = false;
+
+    static int on_progress(void* ptr, curl_off_t, curl_off_t dlnow, curl_off_t, curl_off_t) {
+      auto& self = *static_cast<idle_watcher*>(ptr);
+      const auto now = std::chrono::steady_clock::now();
+
+      if (dlnow != self.received) {
+        self.received = dlnow;
+        self.last_received = now;
+        return 0;
+      }
+
+      self.expired = self.timeout < now - self.last_received;
+      return self.expired ? 1 : 0;
+    }
+  };
+
+  template<typename MethodTag, typename Receiver = detail::default_receiver_t>
+  inline auto request_impl(const detail::url_path_ref& url_path, agent_resource& resource, detail::agent_request_config&& req_cfg, [[maybe_unused]] auto&& req_body, MethodTag, [[maybe_unused]] Receiver&& receiver = {}) -> http_result {
+    // メソッドタイプ判定
+    constexpr bool has_request_body = detail::tag::has_reqbody_method<MethodTag>;
+
+    // メソッド判定
+    constexpr bool is_get = std::is_same_v<detail::tag::get_t, MethodTag>;
+    constexpr bool is_opt = std::is_same_v<detail::tag::options_t, MethodTag>;
+
+    auto& state = resource.state;
+    auto& session = state.session;
+
+    // 転送後（エラー時を含む）に、リクエストボディへの参照をセッションから外す
+    struct request_body_guard {
+      CURL* session;
+      unique_mime& mime;
+
+      ~request_body_guard() {
+        reset_request_body(session, mime);
+      }
+    } body_guard{session.get(), state.mime_body};
+
+    // リクエストの設定
+    unique_slist req_header_list{};
+    if (const auto ec = prepare_request(url_path, resource, req_cfg, req_body, MethodTag{}, req_header_list); ec != CURLE_OK) {
+      return http_result{ec};
+    }
+
+    const auto budget = req_cfg.budget.or_else(resource.config.budget);
+    body_buffer_sink body_sink{ .body = body_buffer_sink::make_body(budget), .handle = session.get(), .budget = budget };
+    header_t headers;
+
+    // 受信コールバックによって転送が一時停止されうるか
+    bool may_pause = false;
+
+    // レスポンスボディコールバックの指定
+    if constexpr (not std::same_as<std::remove_cvref_t<Receiver>, detail::default_receiver_t>) {
+      // 受信コールバックが直接指定されている場合、型消去を介さずにそれを呼び出す
+      using receiver_t = std::remove_reference_t<Receiver>;
+
+      auto* body_recieve = write_callback<receiver_t, [](receiver_t& callback, char* data_ptr, std::size_t data_len) -> std::size_t {
+        return to_write_result(detail::invoke_receiver(callback, std::span<const char>{data_ptr, data_len}), data_len);
+      }>;
+      curl_easy_setopt(session.get(), CURLOPT_WRITEFUNCTION, body_recieve);
+      curl_easy_setopt(session.get(), CURLOPT_WRITEDATA, std::addressof(receiver));
+
+      // 戻り値型がvoidの場合は一時停止されない
+      may_pause = not std::same_as<std::invoke_result_t<receiver_t&, std::span<const char>>, void>;
+    } else if constexpr (has_request_body or is_get or is_opt) {
+      if (req_cfg.streaming_receiver) {
+        // カスタムのコールバックによる応答本文受け取り
+        auto* body_recieve = write_callback<decltype(req_cfg.streaming_receiver), [](decltype(req_cfg.streaming_receiver)& callback, char* data_ptr, std::size_t data_len) -> std::size_t {
+          return to_write_result(callback(std::span<const char>{data_ptr, data_len}), data_len);
+        }>;
+        curl_easy_setopt(session.get(), CURLOPT_WRITEFUNCTION, body_recieve);
+        curl_easy_setopt(session.get(), CURLOPT_WRITEDATA, &req_cfg.streaming_receiver);
+
+        may_pause = true;
+      } else {
+        // デフォルトのコールバック
+        auto* body_recieve = write_callback<body_buffer_sink, body_buffer_sink::on_receive>;
+        curl_easy_setopt(session.get(), CURLOPT_WRITEFUNCTION, body_recieve);
+        curl_easy_setopt(session.get(), CURLOPT_WRITEDATA, &body_sink);
+
+        if (not req_cfg.inspector) {
+          // Content-Lengthが上限を超える場合、ボディを受信せずにエラーとする（0は無制限）
+          // response_inspectorはボディをファイルへ書き出させうるため、その場合は受信時にのみ確認する
+          curl_easy_setopt(session.get(), CURLOPT_MAXFILESIZE_LARGE, static_cast<curl_off_t>(budget.max_body_size));
+        }
+      }
+    }
+
+    // デフォルトの受信先が使用されるか
+    constexpr bool default_sink = std::same_as<std::remove_cvref_t<Receiver>, detail::default_receiver_t>;
+
+    // レスポンスヘッダコールバックの指定
+    response_header_sink header_sink{
+      .headers = headers,
+      .handle = session.get(),
+      .inspector = req_cfg.inspector,
+      .body = (default_sink and not req_cfg.streaming_receiver) ? &body_sink : nullptr,
+      .follow_redirect = resource.follow_redirect.enabled()
+    };
+    auto* header_recieve = write_callback<response_header_sink, response_header_sink::on_receive>;
+    curl_easy_setopt(session.get(), CURLOPT_HEADERFUNCTION, header_recieve);
+    curl_easy_setopt(session.get(), CURLOPT_HEADERDATA, &header_sink);
+
+    idle_watcher idle{ .timeout = req_cfg.idle_timeout };
+    if (req_cfg.idle_timeout.count() != 0) {
+      curl_easy_setopt(session.get(), CURLOPT_XFERINFOFUNCTION, idle_watcher::on_progress);
+      curl_easy_setopt(session.get(), CURLOPT_XFERINFODATA, &idle);
+      curl_easy_setopt(session.get(), CURLOPT_NOPROGRESS, 0L);
+    }
+
+    // 一時停止されうる場合は、再開要求を監視しながら転送する
+    const CURLcode curl_status = may_pause ? perform_pausable(session.get(), resource.multi, req_cfg.flow)
+                                           : curl_easy_perform(session.get());
+
+    if (idle.expired) {
+      return http_result{CURLE_OPERATION_TIMEDOUT};
+    }
+    if (header_sink.exception) {
+      std::rethrow_exception(header_sink.exception);
+    }
+    if (body_sink.error != 0) {
+      throw std::system_error{body_sink.error, std::generic_category()};
+    }
+    if (header_sink.aborted) {
+      return http_result{CURLE_ABORTED_BY_CALLBACK};
+    }
+    if (body_sink.exceeded) {
+      return http_result{CURLE_FILESIZE_EXCEEDED};
+    }
+    if (curl_status != CURLE_OK) {
+      return http_result{curl_status};
+    }
+
+    long http_status;
+    curl_easy_getinfo(session.get(), CURLINFO_RESPONSE_CODE, &http_status);
+
+    if (resource.cookie_management.enabled()) {
+      // リダイレクトなどの途中のレスポンスで設定されたクッキーも保存する
+      if (not header_sink.previous_cookies.empty()) {
+        resource.cookie_vault.insert_from_set_cookie(header_sink.previous_cookies, resource.request_url.host());
+      }
+      // サーバからのクッキーを保存する（あれば
+      if (const auto pos = headers.find("set-cookie"); pos != headers.end()) {
+        resource.cookie_vault.insert_from_set_cookie((*pos).second, resource.request_url.host());
+      }
+    }
+
+    return http_result{chttpp::detail::http_response{ {}, std::move(body_sink.body), std::move(headers), detail::http_status_code{http_status} }};
+  }
+
+  /**
+   * @brief open_stream()で開始された転送の状態
+   * @details curlのコールバックから参照されるため、アドレスが変わらないようにヒープに配置して使用する
+   */
+  struct response_stream_state {
+    unique_curl handle = nullptr;
+    unique_curlm multi = nullptr;
+    // 送信ヘッダは転送完了まで保持する
+    unique_slist req_header_list = nullptr;
+    header_t headers{};
+    // 受信済みで未消費のチャンク（使いまわす）
+    vector_t<char> chunk{};
+    CURLcode result = CURLE_OK;
+    bool paused = false;
+    bool done = false;
+
+    response_stream_state() = default;
+
+    response_stream_state(const response_stream_state&) = delete;
+    response_stream_state& operator=(const response_stream_state&) = delete;
+
+    ~response_stream_state() {
+      if (multi and handle) {
+        curl_multi_remove_handle(multi.get(), handle.get());
+      }
+    }
+
+    /**
+     * @brief レスポンスボディの書き込みコールバック
+     * @details 未消費のチャンクがある場合は転送を一時停止し、受信データが溜まらないようにする
+     */
+    static auto on_receive(response_stream_state& self, char* data_ptr, std::size_t data_len) -> std::size_t {
+      if (not self.chunk.empty()) {
+        self.paused = true;
+        return CURL_WRITEFUNC_PAUSE;
+      }
+
+      self.chunk.assign(data_ptr, data_ptr + data_len);
+
+      return data_len;
+    }
+
+    /**
+     * @brief 次のチャンクを受信するか、転送が完了するまで転送を進める
+     */
+    void fill() {
+      while (chunk.empty() and not done) {
+        if (paused) {
+          paused = false;
+          // 保留されていたデータによって、ここでon_receive()が呼ばれうる
+          curl_easy_pause(handle.get(), CURLPAUSE_CONT);
+          continue;
+        }
+
+        int running = 0;
+        if (curl_multi_perform(multi.get(), &running) != CURLM_OK) {
+          finish(CURLE_RECV_ERROR);
+          break;
+        }
+
+        if (running == 0) {
+          // 転送結果の取得
+          CURLcode transfer_result = CURLE_OK;
+          int remain = 0;
+          while (CURLMsg* msg = curl_multi_info_read(multi.get(), &remain)) {
+            if (msg->msg == CURLMSG_DONE) {
+              transfer_result = msg->data.result;
+            }
+          }
+          finish(transfer_result);
+          break;
+        }
+
+        if (chunk.empty()) {
+          curl_multi_poll(multi.get(), nullptr, 0, 1000, nullptr);
+        }
+      }
+    }
+
+    void finish(CURLcode ec) {
+      result = ec;
+      done = true;
+    }
+  };
+
+  /**
+   * @brief レスポンスボディを、受信したチャンク毎に読み進めるストリーム
+   * @details body()の各要素（std::span<const char>）は、次の要素へ進むと無効になる
+   * @details ストリームを破棄すると、転送は途中であっても中断される
+   */
+  class response_stream {
+    std::unique_ptr<response_stream_state> m_state;
+
+  public:
+
+    class iterator {
+      response_stream_state* m_state = nullptr;
+
+    public:
+      using value_type = std::span<const char>;
+      using difference_type = std::ptrdiff_t;
+      using iterator_concept = std::input_iterator_tag;
+
+      iterator() = default;
+
+      explicit iterator(response_stream_state* state) noexcept
+        : m_state{state}
+      {}
+
+      auto operator*() const noexcept -> std::span<const char> {
+        return { m_state->chunk };
+      }
+
+      auto operator++() -> iterator& {
+        m_state->chunk.clear();
+        m_state->fill();
+        return *this;
+      }
+
+      void operator++(int) {
+        ++*this;
+      }
+
+      friend bool operator==(const iterator& it, std::default_sentinel_t) noexcept {
+        // fill()の後で空であるのは、転送が終了した時のみ
+        return it.m_state == nullptr or it.m_state->chunk.empty();
+      }
+    };
+
+    explicit response_stream(std::unique_ptr<response_stream_state> state) noexcept
+      : m_state{std::move(state)}
+    {}
+
+    /**
+     * @brief 転送を開始できなかった場合のストリームを構築する
+     */
+    explicit response_stream(CURLcode ec)
+      : m_state{std::make_unique<response_stream_state>()}
+    {
+      m_state->finish(ec);
+    }
+
+    response_stream(response_stream&&) = default;
+    response_stream& operator=(response_stream&&) & = default;
+
+    /**
+     * @brief 転送がエラーなく進行しているか
+     * @details ムーブ後のストリームは無効（false）
+     */
+    explicit operator bool() const noexcept {
+      return m_state != nullptr and m_state->result == CURLE_OK;
+    }
+
+    auto error() const -> detail::error_code {
+      if (m_state == nullptr) {
+        // ムーブ後のストリーム
+        return detail::error_code{CURLE_BAD_FUNCTION_ARGUMENT};
+      }
+      if (m_state->result == CURLE_OK) {
+        return detail::error_code{};
+      }
+      return detail::error_code{m_state->result};
+    }
+
+    auto status_code() const -> detail::http_status_code {
+      long http_status = 0;
+      if (m_state != nullptr and m_state->handle) {
+        curl_easy_getinfo(m_state->handle.get(), CURLINFO_RESPONSE_CODE, &http_status);
+      }
+      return detail::http_status_code{http_status};
+    }
+
+    auto response_headers() const & -> detail::header_ref {
+      return detail::header_ref{m_state != nullptr ? &m_state->headers : nullptr};
+    }
+
+    auto response_header(std::string_view header_name) const & -> std::string_view {
+      if (m_state == nullptr) {
+        return {};
+      }
+
+      const auto pos = m_state->headers.find(header_name);
+      if (pos == m_state->headers.end()) {
+        return {};
+      }
+
+      return (*pos).second;
+    }
+
+    /**
+     * @brief レスポンスボディのチャンクを順に返すinput_range
+     * @details イテレータを進めるたびに転送を進めるため、メモリ使用量はボディの長さによらない
+     */
+    auto body() & -> std::ranges::subrange<iterator, std::default_sentinel_t> {
+      return { iterator{m_state.get()}, std::default_sentinel };
+    }
+  };
+
+  template<typename MethodTag>
+  inline auto open_stream_impl(const detail::url_path_ref& url_path, agent_resource& resource, detail::agent_request_config&& req_cfg, [[maybe_unused]] std::span<const char> req_body, MethodTag) -> response_stream {
+    auto state_ptr = std::make_unique<response_stream_state>();
+    auto& st = *state_ptr;
+
+    const auto setup = [&]() -> CURLcode {
+      if (const auto ec = prepare_request(url_path, resource, req_cfg, req_body, MethodTag{}, st.req_header_list); ec != CURLE_OK) {
+        return ec;
+      }
+
+      // agentのセッションを複製し、agentとは独立に転送を進める
+      st.handle.reset(curl_easy_duphandle(resource.state.session.get()));
+      st.multi.reset(curl_multi_init());
+
+      if (not st.handle or not st.multi) {
+        return CURLE_FAILED_INIT;
+      }
+
+      // ストリームはagentより長く生存しうるため、agentの接続キャッシュを共有しない
+      curl_easy_setopt(st.handle.get(), CURLOPT_SHARE, nullptr);
+
+      auto* body_recieve = write_callback<response_stream_state, response_stream_state::on_receive>;
+      curl_easy_setopt(st.handle.get(), CURLOPT_WRITEFUNCTION, body_recieve);
+      curl_easy_setopt(st.handle.get(), CURLOPT_WRITEDATA, &st);
+
+      auto* header_recieve = write_callback<header_t, chttpp::detail::parse_response_header_on_curl>;
+      curl_easy_setopt(st.handle.get(), CURLOPT_HEADERFUNCTION, header_recieve);
+      curl_easy_setopt(st.handle.get(), CURLOPT_HEADERDATA, &st.headers);
+
+      curl_easy_setopt(st.handle.get(), CURLOPT_NOPROGRESS, 1L);
+
+      if (curl_multi_add_handle(st.multi.get(), st.handle.get()) != CURLM_OK) {
+        return CURLE_FAILED_INIT;
+      }
+
+      return CURLE_OK;
+    };
+
+    if (const auto ec = setup(); ec != CURLE_OK) {
+      st.finish(ec);
+      return response_stream{std::move(state_ptr)};
+    }
+
+    // 最初のチャンクを受信する（ここまででレスポンスヘッダは受信済みとなる）
+    st.fill();
+
+    if (resource.cookie_management.enabled()) {
+      // サーバからのクッキーを保存する（あれば
+      if (const auto pos = st.headers.find("set-cookie"); pos != st.headers.end()) {
+        resource.cookie_vault.insert_from_set_cookie((*pos).second, resource.request_url.host());
+      }
+    }
+
+    return response_stream{std::move(state_ptr)};
+  }
+
+  /**
+   * @brief ダウンロードしたレスポンスボディを、バッファリングしつつファイルへ書き出す
+   * @details レスポンスボディの最初のチャンクを受信した時点（ボディが空の場合は転送の完了後）で、ステータスコードに応じて書き込み位置を決定する
+   */
+  struct download_sink {
+    CURL* handle;
+    int fd;
+    const header_t* headers;
+    const detail::download_config* config;
+    // Rangeで要求した開始位置
+    std::uint64_t requested_offset = 0;
+    // 次にファイルへ書き出す位置（バッファの先頭に対応する）
+    std::uint64_t position = 0;
+    vector_t<char> buffer{};
+    // ファイル操作で発生したエラー（errno）
+    int error = 0;
+    bool started = false;
+    // ボディをファイルへ書き込むか（エラーレスポンスのボディは捨てる）
+    bool writing = false;
+    // 部分レスポンス（206）以外を受け付けない
+    bool require_partial = false;
+
+    /**
+     * @brief バッファの内容を現在位置へ書き出す
+     */
+    bool flush() {
+      std::size_t written = 0;
+
+      while (written < buffer.size()) {
+        const auto len = ::pwrite(fd, buffer.data() + written, buffer.size() - written, static_cast<off_t>(position + written));
+        if (len < 0) {
+          if (errno == EINTR) continue;
+          error = errno;
+          break;
+        }
+        written += static_cast<std::size_t>(len);
+      }
+
+      position += written;
+      buffer.erase(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(written));
+
+      if (error == 0 and written != 0 and config->sync == fsync_policy::every_flush) {
+        if (::fdatasync(fd) != 0) {
+          error = errno;
+        }
+      }
+
+      return error == 0;
+    }
+
+    /**
+     * @brief 最初のチャンクの受信時に、レスポンスに応じてファイルの書き込み位置を決める
+     */
+    bool start() {
+      started = true;
+
+      long http_status = 0;
+      curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &http_status);
+
+      if (http_status == 206) {
+        // Content-Rangeの開始位置が要求した位置と一致しない場合、ファイルが壊れるため中断する
+        const auto pos = headers->find("content-range");
+        if (pos == headers->end()) {
+          return false;
+        }
+        if (const auto range = detail::parse_content_range((*pos).second); not range or not range->has_range or range->first != requested_offset) {
+          return false;
+        }
+        position = requested_offset;
+      } else if (200 <= http_status and http_status < 300) {
+        if (require_partial) {
+          return false;
+        }
+
+        // Rangeが無視されたか、If-Rangeが一致せずに全体が送られてきた
+        if (::ftruncate(fd, 0) != 0) {
+          error = errno;
+          return false;
+        }
+        position = 0;
+      } else {
+        // エラーレスポンスのボディでファイルを書き換えない
+        return true;
+      }
+
+      writing = true;
+      buffer.reserve(config->buffer_size);
+
+      if (config->preallocate) {
+        curl_off_t remain = -1;
+        curl_easy_getinfo(handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &remain);
+
+#ifdef __linux__
+        if (0 < remain) {
+          // ファイルサイズを変更しないことで、中断された場合もファイルサイズから再開できるようにする
+          // ファイルシステムが対応していない場合もあるため、失敗は無視する
+          [[maybe_unused]]
+          const int ec = ::fallocate(fd, FALLOC_FL_KEEP_SIZE, static_cast<off_t>(position), static_cast<off_t>(remain));
+        }
+#endif
+      }
+
+      return true;
+    }
+
+    static auto on_receive(download_sink& self, char* data_ptr, std::size_t data_len) -> std::size_t {
+      if (not self.started and not self.start()) {
+        return 0;
+      }
+
+      if (not self.writing) {
+        return data_len;
+      }
+
+      self.buffer.insert(self.buffer.end(), data_ptr, data_ptr + data_len);
+
+      if (self.config->buffer_size <= self.buffer.size() and not self.flush()) {
+        return 0;
+      }
+
+      return data_len;
+    }
+  };
+
+  /**
+   * @brief 中断された転送のうち、続きから再試行するべきもの
+   */
+  inline bool is_resumable_error(CURLcode ec) noexcept {
+    switch (ec) {
+      case CURLE_PARTIAL_FILE:
+      case CURLE_RECV_ERROR:
+      case CURLE_SEND_ERROR:
+      case CURLE_GOT_NOTHING:
+      case CURLE_OPERATION_TIMEDOUT:
+      case CURLE_HTTP2_STREAM:
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  /**
+   * @brief 強いETagかLast-Modifiedを、If-Rangeに使用する値として取り出す
+   */
+  inline auto range_validator(const header_t& headers) -> std::string_view {
+    if (const auto pos = headers.find("etag"); pos != headers.end() and not (*pos).second.starts_with("W/")) {
+      return (*pos).second;
+    }
+    if (const auto pos = headers.find("last-modified"); pos != headers.end()) {
+      return (*pos).second;
+    }
+    return {};
+  }
+
+  template<typename MethodTag>
+  inline auto download_impl(const detail::url_path_ref& url_path, agent_resource& resource, detail::agent_request_config&& req_cfg, const std::filesystem::path& file_path, const detail::download_config& dl_cfg, MethodTag) -> http_result {
+    auto& session = resource.state.session;
+    req_cfg.identity_encoding = true;
+
+    const int fd = ::open(file_path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+      throw std::system_error{errno, std::generic_category(), file_path.string()};
+    }
+    // 例外が送出されてもファイルを閉じる
+    std::unique_ptr<const int, decltype([](const int* pfd) { ::close(*pfd); })> close_fd{&fd};
+
+    std::uint64_t offset = 0;
+    if (dl_cfg.resume) {
+      struct stat st{};
+      if (::fstat(fd, &st) != 0) {
+        throw std::system_error{errno, std::generic_category(), file_path.string()};
+      }
+      offset = static_cast<std::uint64_t>(st.st_size);
+    } else if (::ftruncate(fd, 0) != 0) {
+      throw std::system_error{errno, std::generic_category(), file_path.string()};
+    }
+
+    // If-Rangeで送信する値、再試行時には最初のレスポンスから取得する
+    string_t validator{dl_cfg.validator};
+    header_t headers;
+    CURLcode curl_status = CURLE_OK;
+
+    for (unsigned int attempt = 0; ; ++attempt) {
+      unique_slist req_header_list{};
+      if (const auto ec = prepare_request(url_path, resource, req_cfg, std::span<const char>{}, MethodTag{}, req_header_list); ec != CURLE_OK) {
+        return http_result{ec};
+      }
+
+      if (offset != 0) {
+        // 既存の部分の続きから要求する
+        resource.state.buffer.use([&](string_t& header_buffer) {
+          header_buffer.append("Range: bytes=");
+          header_buffer.append(std::to_string(offset));
+          header_buffer.append("-");
+          unique_slist_append(req_header_list, header_buffer.c_str());
+        });
+
+        if (not validator.empty()) {
+          // 取得済みの部分と同じリソースである場合のみ、部分レスポンスを受け取る
+          resource.state.buffer.use([&](string_t& header_buffer) {
+            header_buffer.append("If-Range: ");
+            header_buffer.append(validator);
+            unique_slist_append(req_header_list, header_buffer.c_str());
+          });
+        }
+
+        curl_easy_setopt(session.get(), CURLOPT_HTTPHEADER, req_header_list.get());
+      }
+
+      headers.clear();
+      download_sink sink{ .handle = session.get(), .fd = fd, .headers = &headers, .config = &dl_cfg, .requested_offset = offset };
+
+      auto* body_recieve = write_callback<download_sink, download_sink::on_receive>;
+      curl_easy_setopt(session.get(), CURLOPT_WRITEFUNCTION, body_recieve);
+      curl_easy_setopt(session.get(), CURLOPT_WRITEDATA, &sink);
+
+      auto* header_recieve = write_callback<header_t, chttpp::detail::parse_response_header_on_curl>;
+      curl_easy_setopt(session.get(), CURLOPT_HEADERFUNCTION, header_recieve);
+      curl_easy_setopt(session.get(), CURLOPT_HEADERDATA, &headers);
+
+      curl_status = curl_easy_perform(session.get());
+
+      // ボディが空の場合は受信時に書き込み位置が決まらないため、ここで決める（空の200で既存のファイルを切り詰める）
+      if (curl_status == CURLE_OK and not sink.started and not sink.start()) {
+        curl_status = CURLE_WRITE_ERROR;
+      }
+
+      // 途中で切断された場合も、受信済みの部分は書き出しておく
+      if (sink.writing) {
+        sink.flush();
+      }
+
+      if (sink.error != 0) {
+        throw std::system_error{sink.error, std::generic_category(), file_path.string()};
+      }
+
+      if (curl_status == CURLE_OK) {
+        if (sink.writing and dl_cfg.sync != fsync_policy::none and ::fsync(fd) != 0) {
+          throw std::system_error{errno, std::generic_category(), file_path.string()};
+        }
+        break;
+      }
+
+      if (not sink.writing or not is_resumable_error(curl_status) or dl_cfg.max_retry <= attempt) {
+        break;
+      }
+
+      // 続きから再試行する
+      offset = sink.position;
+
+      if (validator.empty()) {
+        // 弱いETagはIf-Rangeに使用できない
+        validator = range_validator(headers);
+
+        if (validator.empty()) {
+          // 同じリソースであることを確認できない
+          break;
+        }
+      }
+    }
+
+    if (curl_status != CURLE_OK) {
+      return http_result{curl_status};
+    }
+
+    long http_status;
+    curl_easy_getinfo(session.get(), CURLINFO_RESPONSE_CODE, &http_status);
+
+    if (http_status == 416 and offset != 0) {
+      // 全体の長さが取得済みの長さと一致する場合、ファイルは既に完全なものとなっている
+      if (const auto pos = headers.find("content-range"); pos != headers.end()) {
+        if (const auto range = detail::parse_content_range((*pos).second); range and not range->has_range and range->length == offset) {
+          http_status = 200;
+        }
+      }
+    }
+
+    if (resource.cookie_management.enabled()) {
+      // サーバからのクッキーを保存する（あれば
+      if (const auto pos = headers.find("set-cookie"); pos != headers.end()) {
+        resource.cookie_vault.insert_from_set_cookie((*pos).second, resource.request_url.host());
+      }
+    }
+
+    return http_result{chttpp::detail::http_response{ {}, detail::make_response_body(), std::move(headers), detail::http_status_code{http_status} }};
+  }
+
+  /**
+   * @brief parallel_download()で分割された1つの部分の転送状態
+   * @details sinkがheadersを参照するため、アドレスが変わらないように配置する
+   */
+  struct download_part {
+    unique_curl handle = nullptr;
+    header_t headers{};
+    download_sink sink{};
+    // この部分の最後の位置（閉区間）
+    std::uint64_t last = 0;
+    unsigned int attempt = 0;
+    // CURLOPT_RANGEに渡す文字列（転送中は保持する）
+    char range[48]{};
+  };
+
+  inline auto parallel_download_impl(const detail::url_path_ref& url_path, agent_resource& resource, detail::agent_request_config&& req_cfg, const std::filesystem::path& file_path, const detail::parallel_download_config& pd_cfg) -> http_result {
+    auto& session = resource.state.session;
+    // 各部分の転送は準備したセッションを複製するため、この指定を引き継ぐ
+    req_cfg.identity_encoding = true;
+
+    // サイズと、範囲リクエストの可否を調べる
+    header_t head_headers;
+    {
+      unique_slist req_header_list{};
+      if (const auto ec = prepare_request(url_path, resource, req_cfg, std::span<const char>{}, detail::tag::head_t{}, req_header_list); ec != CURLE_OK) {
+        return http_result{ec};
+      }
+
+      auto* header_recieve = write_callback<header_t, chttpp::detail::parse_response_header_on_curl>;
+      curl_easy_setopt(session.get(), CURLOPT_HEADERFUNCTION, header_recieve);
+      curl_easy_setopt(session.get(), CURLOPT_HEADERDATA, &head_headers);
+
+      if (const auto ec = curl_easy_perform(session.get()); ec != CURLE_OK) {
+        return http_result{ec};
+      }
+    }
+
+    long http_status;
+    curl_easy_getinfo(session.get(), CURLINFO_RESPONSE_CODE, &http_status);
+
+    if (resource.cookie_management.enabled()) {
+      if (const auto pos = head_headers.find("set-cookie"); pos != head_headers.end()) {
+        resource.cookie_vault.insert_from_set_cookie((*pos).second, resource.request_url.host());
+      }
+    }
+
+    if (http_status < 200 or 300 <= http_status) {
+      return http_result{chttpp::detail::http_response{ {}, detail::make_response_body(), std::move(head_headers), detail::http_status_code{http_status} }};
+    }
+
+    curl_off_t content_length = -1;
+    curl_easy_getinfo(session.get(), CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &content_length);
+
+    const auto accept_ranges = head_headers.find("accept-ranges");
+    const bool rangeable = accept_ranges != head_headers.end() and (*accept_ranges).second.find("bytes") != std::string_view::npos;
+
+    const std::uint64_t total = content_length < 0 ? 0 : static_cast<std::uint64_t>(content_length);
+    const std::uint64_t part_count = std::min<std::uint64_t>(std::max(pd_cfg.parts, 1u), total / std::max<std::size_t>(pd_cfg.min_part_size, 1));
+
+    const detail::download_config sink_cfg{ .resume = false, .preallocate = false, .sync = pd_cfg.sync, .buffer_size = pd_cfg.buffer_size, .max_retry = pd_cfg.max_retry };
+
+    if (not rangeable or part_count <= 1) {
+      // 分割できない場合は、1つの接続でダウンロードする
+      return download_impl(url_path, resource, std::move(req_cfg), file_path, sink_cfg, detail::tag::get_t{});
+    }
+
+    const int fd = ::open(file_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+      throw std::system_error{errno, std::generic_category(), file_path.string()};
+    }
+    std::unique_ptr<const int, decltype([](const int* pfd) { ::close(*pfd); })> close_fd{&fd};
+
+    // 全体の長さのファイルを用意し、各部分はそれぞれの位置へ書き込む
+    if (::ftruncate(fd, static_cast<off_t>(total)) != 0) {
+      throw std::system_error{errno, std::generic_category(), file_path.string()};
+    }
+#ifdef __linux__
+    {
+      // ファイルシステムが対応していない場合もあるため、失敗は無視する
+      [[maybe_unused]]
+      const int ec = ::fallocate(fd, 0, 0, static_cast<off_t>(total));
+    }
+#endif
+
+    // 各部分の転送はagentのセッションを複製して行うため、ヘッダや認証情報などは共通となる
+    unique_slist req_header_list{};
+    if (const auto ec = prepare_request(url_path, resource, req_cfg, std::span<const char>{}, detail::tag::get_t{}, req_header_list); ec != CURLE_OK) {
+      return http_result{ec};
+    }
+
+    if (const auto validator = range_validator(head_headers); not validator.empty()) {
+      // 転送中にリソースが更新された場合、部分レスポンスは返されない
+      resource.state.buffer.use([&](string_t& header_buffer) {
+        header_buffer.append("If-Range: ");
+        header_buffer.append(validator);
+        unique_slist_append(req_header_list, header_buffer.c_str());
+      });
+      curl_easy_setopt(session.get(), CURLOPT_HTTPHEADER, req_header_list.get());
+    }
+
+    unique_curlm multi{curl_multi_init()};
+    if (not multi) {
+      return http_result{CURLE_FAILED_INIT};
+    }
+    // HTTP/2で1つの接続に多重化されると、接続を分ける意味がなくなる
+    curl_multi_setopt(multi.get(), CURLMOPT_PIPELINING, CURLPIPE_NOTHING);
+
+    auto parts = std::make_unique<download_part[]>(part_count);
+
+    // 指定位置から、その部分の最後までの転送を開始する
+    const auto start_part = [&](download_part& part, std::uint64_t first) -> CURLcode {
+      part.headers.clear();
+      part.sink = download_sink{ .handle = part.handle.get(), .fd = fd, .headers = &part.headers, .config = &sink_cfg, .requested_offset = first, .require_partial = true };
+
+      auto* last_ptr = std::to_chars(part.range, part.range + sizeof(part.range) - 1, first).ptr;
+      *last_ptr++ = '-';
+      *std::to_chars(last_ptr, part.range + sizeof(part.range) - 1, part.last).ptr = '\0';
+
+      curl_easy_setopt(part.handle.get(), CURLOPT_RANGE, part.range);
+
+      auto* body_recieve = write_callback<download_sink, download_sink::on_receive>;
+      curl_easy_setopt(part.handle.get(), CURLOPT_WRITEFUNCTION, body_recieve);
+      curl_easy_setopt(part.handle.get(), CURLOPT_WRITEDATA, &part.sink);
+
+      auto* header_recieve = write_callback<header_t, chttpp::detail::parse_response_header_on_curl>;
+      curl_easy_setopt(part.handle.get(), CURLOPT_HEADERFUNCTION, header_recieve);
+      curl_easy_setopt(part.handle.get(), CURLOPT_HEADERDATA, &part.headers);
+
+      if (curl_multi_add_handle(multi.get(), part.handle.get()) != CURLM_OK) {
+        return CURLE_FAILED_INIT;
+      }
+
+      return CURLE_OK;
+    };
+
+    const std::uint64_t part_len = total / part_count;
+
+    for (std::uint64_t i = 0; i < part_count; ++i) {
+      auto& part = parts[i];
+      part.last = (i == part_count - 1) ? total - 1 : (i + 1) * part_len - 1;
+      part.handle.reset(curl_easy_duphandle(session.get()));
+
+      if (not part.handle) {
+        return http_result{CURLE_FAILED_INIT};
+      }
+
+      if (const auto ec = start_part(part, i * part_len); ec != CURLE_OK) {
+        return http_result{ec};
+      }
+    }
+
+    std::uint64_t pending = part_count;
+    CURLcode failure = CURLE_OK;
+
+    while (pending != 0 and failure == CURLE_OK) {
+      int running = 0;
+      if (curl_multi_perform(multi.get(), &running) != CURLM_OK) {
+        failure = CURLE_RECV_ERROR;
+        break;
+      }
+
+      int remain = 0;
+      while (CURLMsg* msg = curl_multi_info_read(multi.get(), &remain)) {
+        if (msg->msg != CURLMSG_DONE) {
+          continue;
+        }
+
+        const CURLcode result = msg->data.result;
+        auto& part = *std::ranges::find(parts.get(), parts.get() + part_count, msg->easy_handle, [](const download_part& p) { return p.handle.get(); });
+        curl_multi_remove_handle(multi.get(), part.handle.get());
+
+        auto& sink = part.sink;
+        if (sink.writing) {
+          sink.flush();
+        }
+        if (sink.error != 0) {
+          throw std::system_error{sink.error, std::generic_category(), file_path.string()};
+        }
+
+        if (sink.started and not sink.writing) {
+          // 部分レスポンスが返されなかった
+          failure = CURLE_RANGE_ERROR;
+        } else if (result == CURLE_OK) {
+          if (sink.position != part.last + 1) {
+            failure = CURLE_PARTIAL_FILE;
+          } else {
+            --pending;
+          }
+        } else if (is_resumable_error(result) and part.attempt < pd_cfg.max_retry) {
+          // この部分だけを、続きから再試行する
+          ++part.attempt;
+          failure = start_part(part, sink.writing ? sink.position : sink.requested_offset);
+        } else {
+          failure = result;
+        }
+      }
+
+      if (pending != 0 and failure == CURLE_OK) {
+        curl_multi_poll(multi.get(), nullptr, 0, 1000, nullptr);
+      }
+    }
+
+    if (failure != CURLE_OK) {
+      return http_result{failure};
+    }
+
+    if (pd_cfg.sync != fsync_policy::none and ::fsync(fd) != 0) {
+      throw std::system_error{errno, std::generic_category(), file_path.string()};
+    }
+
+    return http_result{chttpp::detail::http_response{ {}, detail::make_response_body(), std::move(head_headers), detail::http_status_code{http_status} }};
+  }
+
+  template<typename... Args>
+  auto parallel_download_impl(const detail::url_path_ref& url_path, dummy_buffer, Args&&... args) noexcept -> http_result try {
+    // bufferをはがすだけ
+    return parallel_download_impl(url_path, std::forward<Args>(args)...);
+  } catch (...) {
+    return http_result{detail::from_exception_ptr};
+  }
+
+  template<typename... Args>
+  auto parallel_download_impl(std::wstring_view url_path, detail::string_buffer& buffer, Args&&... args) noexcept -> http_result try {
+    // path文字列をcharへ変換する
+    return buffer.use([&](string_t& converted_url) {
+        if (wchar_to_char(url_path, converted_url)) {
+          return http_result{ CURLcode::CURLE_CONV_FAILED };
+        }
+
+        return parallel_download_impl(converted_url, std::forward<Args>(args)...);
+      });
+  } catch (...) {
+    return http_result{detail::from_exception_ptr};
+  }
+
+  inline auto tail_impl(const detail::url_path_ref& url_path, agent_resource& resource, detail::agent_request_config&& req_cfg) -> http_result {
+    auto& session = resource.state.session;
+    req_cfg.identity_encoding = true;
+
+    // URLパラメータが異なれば別のリソースとなるため、エンコードしたパラメータを付加したパスで区別する
+    const auto it = resource.state.buffer.use([&](string_t& key) {
+      url_path.append_to(key);
+      detail::append_query_params(key, req_cfg.params);
+
+      if (const auto pos = resource.tail_states.find(key); pos != resource.tail_states.end()) {
+        return pos;
+      }
+      return resource.tail_states.emplace(key, tail_state{}).first;
+    });
+    auto& tail = (*it).second;
+
+    unique_slist req_header_list{};
+    if (const auto ec = prepare_request(url_path, resource, req_cfg, std::span<const char>{}, detail::tag::get_t{}, req_header_list); ec != CURLE_OK) {
+      return http_result{ec};
+    }
+
+    if (tail.offset != 0) {
+      resource.state.buffer.use([&](string_t& header_buffer) {
+        header_buffer.append("Range: bytes=");
+        header_buffer.append(std::to_string(tail.offset));
+        header_buffer.append("-");
+        unique_slist_append(req_header_list, header_buffer.c_str());
+      });
+
+      if (not tail.validator.empty()) {
+        // リソースが置き換えられている場合は、全体が返される
+        resource.state.buffer.use([&](string_t& header_buffer) {
+          header_buffer.append("If-Range: ");
+          header_buffer.append(tail.validator);
+          unique_slist_append(req_header_list, header_buffer.c_str());
+        });
+      }
+
+      curl_easy_setopt(session.get(), CURLOPT_HTTPHEADER, req_header_list.get());
+    }
+
+    auto body = detail::make_response_body();
+    header_t headers;
+
+    auto* body_recieve = write_callback<decltype(body), [](decltype(body)& buffer, char* data_ptr, std::size_t data_len) {
+      buffer.insert(buffer.end(), data_ptr, data_ptr + data_len);
+    }>;
+    curl_easy_setopt(session.get(), CURLOPT_WRITEFUNCTION, body_recieve);
+    curl_easy_setopt(session.get(), CURLOPT_WRITEDATA, &body);
+
+    auto* header_recieve = write_callback<decltype(headers), chttpp::detail::parse_response_header_on_curl>;
+    curl_easy_setopt(session.get(), CURLOPT_HEADERFUNCTION, header_recieve);
+    curl_easy_setopt(session.get(), CURLOPT_HEADERDATA, &headers);
+
+    if (const auto ec = curl_easy_perform(session.get()); ec != CURLE_OK) {
+      return http_result{ec};
+    }
+
+    long http_status;
+    curl_easy_getinfo(session.get(), CURLINFO_RESPONSE_CODE, &http_status);
+
+    const auto content_range = [&]() -> std::optional<detail::content_range> {
+      if (const auto pos = headers.find("content-range"); pos != headers.end()) {
+        return detail::parse_content_range((*pos).second);
+      }
+      return std::nullopt;
+    }();
+
+    if (http_status == 206) {
+      // 前回の続き
+      if (not content_range or not content_range->has_range or content_range->first != tail.offset) {
+        return http_result{CURLE_RANGE_ERROR};
+      }
+      tail.offset = content_range->last + 1;
+      tail.validator = range_validator(headers);
+    } else if (http_status == 200) {
+      // 初回か、リソースが置き換えられた（全体が返される）
+      tail.offset = body.size();
+      tail.validator = range_validator(headers);
+    } else if (http_status == 416) {
+      // エラーレスポンスのボディは追加された部分ではない
+      body.clear();
+
+      // 追記されていない、リソースが短くなっている場合は次回に最初から取得する
+      if (content_range and content_range->length != detail::content_range::unknown_length and content_range->length < tail.offset) {
+        tail = tail_state{};
+      }
+    }
+
+    if (resource.cookie_management.enabled()) {
+      if (const auto pos = headers.find("set-cookie"); pos != headers.end()) {
+        resource.cookie_vault.insert_from_set_cookie((*pos).second, resource.request_url.host());
+      }
+    }
+
+    return http_result{chttpp::detail::http_response{ {}, std::move(body), std::move(headers), detail::http_status_code{http_status} }};
+  }
+
+  template<typename... Args>
+  auto tail_impl(const detail::url_path_ref& url_path, dummy_buffer, Args&&... args) noexcept -> http_result try {
+    // bufferをはがすだけ
+    return tail_impl(url_path, std::forward<Args>(args)...);
+  } catch (...) {
+    return http_result{detail::from_exception_ptr};
+  }
+
+  template<typename... Args>
+  auto tail_impl(std::wstring_view url_path, detail::string_buffer& buffer, Args&&... args) noexcept -> http_result try {
+    // path文字列をcharへ変換する
+    return buffer.use([&](string_t& converted_url) {
+        if (wchar_to_char(url_path, converted_url)) {
+          return http_result{ CURLcode::CURLE_CONV_FAILED };
+        }
+
+        return tail_impl(converted_url, std::forward<Args>(args)...);
+      });
+  } catch (...) {
+    return http_result{detail::from_exception_ptr};
+  }
+
+  /**
+   * @brief tail()で記録しているリソースの状態を破棄する
+   */
+  inline void reset_tail(const detail::url_path_ref& url_path, dummy_buffer, agent_resource& resource, const detail::agent_request_config& req_cfg) {
+    resource.state.buffer.use([&](string_t& key) {
+      url_path.append_to(key);
+      detail::append_query_params(key, req_cfg.params);
+
+      if (const auto it = resource.tail_states.find(key); it != resource.tail_states.end()) {
+        resource.tail_states.erase(it);
+      }
+    });
+  }
+
+  inline void reset_tail(std::wstring_view url_path, detail::string_buffer& buffer, agent_resource& resource, const detail::agent_request_config& req_cfg) {
+    buffer.use([&](string_t& converted_url) {
+      if (not wchar_to_char(url_path, converted_url)) {
+        reset_tail(converted_url, dummy_buffer{}, resource, req_cfg);
+      }
+    });
+  }
+
+  template<typename... Args>
+  auto download_impl(const detail::url_path_ref& url_path, dummy_buffer, Args&&... args) noexcept -> http_result try {
+    // bufferをはがすだけ
+    return download_impl(url_path, std::forward<Args>(args)...);
+  } catch (...) {
+    return http_result{detail::from_exception_ptr};
+  }
+
+  template<typename... Args>
+  auto download_impl(std::wstring_view url_path, detail::string_buffer& buffer, Args&&... args) noexcept -> http_result try {
+    // path文字列をcharへ変換する
+    return buffer.use([&](string_t& converted_url) {
+        if (wchar_to_char(url_path, converted_url)) {
+          return http_result{ CURLcode::CURLE_CONV_FAILED };
+        }
+
+        return download_impl(converted_url, std::forward<Args>(args)...);
+      });
+  } catch (...) {
+    return http_result{detail::from_exception_ptr};
+  }
+
+  template<typename... Args>
+  auto open_stream_impl(const detail::url_path_ref& url_path, dummy_buffer, Args&&... args) -> response_stream {
+    // bufferをはがすだけ
+    return open_stream_impl(url_path, std::forward<Args>(args)...);
+  }
+
+  template<typename... Args>
+  auto open_stream_impl(std::wstring_view url_path, detail::string_buffer& buffer, Args&&... args) -> response_stream {
+    // path文字列をcharへ変換する
+    return buffer.use([&](string_t& converted_url) {
+        if (wchar_to_char(url_path, converted_url)) {
+          return response_stream{CURLE_CONV_FAILED};
+        }
+
+        return open_stream_impl(converted_url, std::forward<Args>(args)...);
+      });
   }
 
   template<typename... Args>
-  auto request_impl(std::string_view url_path, dummy_buffer, Args&&... args) noexcept -> http_result try {
+  auto request_impl(const detail::url_path_ref& url_path, dummy_buffer, Args&&... args) noexcept -> http_result try {
     // bufferをはがすだけ
     return request_impl(url_path, std::forward<Args>(args)...);
   } catch (...) {
@@ -10,6 +10,7 @@
 #include <format>
 #include <numeric>
 #include <execution>
+#include <thread>
 
 #define WIN32_LEAN_AND_MEAN
 #define NOMINMAX
@@ -25,6 +26,8 @@ namespace chttpp::underlying {
 
     static constexpr DWORD url_error_value = ERROR_WINHTTP_INVALID_URL;
 
+    static constexpr DWORD range_error_value = ERROR_WINHTTP_INVALID_SERVER_RESPONSE;
+
     static auto error_to_string(DWORD err) -> string_t {
       constexpr std::ptrdiff_t max_len = 192;
       string_t str{};
@@ -395,7 +398,8 @@ namespace chttpp::underlying {
     return true;
   }
 
-  inline bool receive_response_body(HINTERNET req_handle, detail::streaming_callback& receiver, vector_t<char>& buffer) {
+  template<detail::body_receiver Receiver>
+  bool receive_response_body(HINTERNET req_handle, Receiver& receiver, vector_t<char>& buffer, detail::flow_control* flow = nullptr) {
     DWORD read_len{};
 
     // QueryDataAvailableもReadDataも少しづつ（8000バイトちょい）しか読み込んでくれないので、全部読み取るにはデータがなくなるまでループする
@@ -418,7 +422,23 @@ namespace chttpp::underlying {
         return false;
       }
 
-      receiver({ buffer.data(), read_len });
+      receive_status status = detail::invoke_receiver(receiver, { buffer.data(), read_len });
+
+      // 一時停止された場合、再開後に同じデータを再度渡す
+      while (status == receive_status::pause) {
+        if (flow != nullptr) {
+          flow->wait_resume();
+        } else {
+          std::this_thread::yield();
+        }
+        status = detail::invoke_receiver(receiver, { buffer.data(), read_len });
+      }
+
+      if (status == receive_status::abort) {
+        // 受信側から中断された
+        ::SetLastError(ERROR_WINHTTP_OPERATION_CANCELLED);
+        return false;
+      }
     } while (0 < read_len);
 
     return true;
@@ -656,7 +676,7 @@ namespace chttpp::underlying::terse {
     }
 
     // レスポンスデータの取得
-    vector_t<char> body{};
+    auto body = detail::make_response_body();
     if constexpr (has_request_body or is_get or is_opt) {
       DWORD read_len{};
       std::size_t total_read{};
@@ -780,8 +800,8 @@ namespace chttpp::underlying::agent_impl {
   };
 
 
-  template<typename MethodTag>
-  auto request_impl(std::wstring_view, agent_resource& resource, detail::agent_request_config&& req_cfg, [[maybe_unused]] std::span<const char> req_body, MethodTag) -> http_result {
+  template<typename MethodTag, typename Receiver = detail::default_receiver_t>
+  auto request_impl(std::wstring_view, agent_resource& resource, detail::agent_request_config&& req_cfg, [[maybe_unused]] std::span<const char> req_body, MethodTag, [[maybe_unused]] Receiver&& receiver = {}) -> http_result {
     // メソッドタイプ判定
     constexpr bool has_request_body = detail::tag::has_reqbody_method<MethodTag>;
 
@@ -866,7 +886,7 @@ namespace chttpp::underlying::agent_impl {
     }
 
     if constexpr (has_request_body or is_get or is_opt) {
-      if (resource.auto_decomp.enabled()) {
+      if (resource.auto_decomp.enabled() and not req_cfg.identity_encoding) {
         // レスポンスデータを自動で解凍する
         // libcurlと異なりwinhttpの場合、ここの設定はユーザーのヘッダ指定を上書きする
         // 従って、Accept-Encodingの指定と自動解凍設定を分離できない・・・
@@ -992,11 +1012,17 @@ namespace chttpp::underlying::agent_impl {
     }
     
     // レスポンスデータの取得
-    vector_t<char> body{};
-    if constexpr (has_request_body or is_get or is_opt) {
+    auto body = detail::make_response_body();
+    if constexpr (not std::same_as<std::remove_cvref_t<Receiver>, detail::default_receiver_t>) {
+      // 受信コールバックが直接指定されている場合、型消去を介さずにそれを呼び出す
+      if (not receive_response_body(request.get(), receiver, body, req_cfg.flow)) {
+        return http_result{ ::GetLastError() };
+      }
+      body.clear();
+    } else if constexpr (has_request_body or is_get or is_opt) {
       if (bool(req_cfg.streaming_receiver)) {
         // データ受信時コールバックの呼び出し
-        if (not receive_response_body(request.get(), req_cfg.streaming_receiver, body)) {
+        if (not receive_response_body(request.get(), req_cfg.streaming_receiver, body, req_cfg.flow)) {
           return http_result{ ::GetLastError() };
         }
         body.clear();
@@ -6,4 +6,9 @@ int main() {
   status_code_test();
   cookie_test();
   exptr_wrapper_test();
+  streaming_receiver_test();
+  request_body_test();
+  range_request_test();
+  sinks_test();
+  json_view_test();
 }
\ No newline at end of file
@@ -1,11 +1,13 @@
 //#define CHTTPP_NOT_GLOBAL_INIT_CURL
 #include "chttpp.hpp"
+#include "json_view.hpp"
 #include "mime_types.hpp"
 #include "http_headers.hpp"
 
 #include <type_traits>
 #include <cassert>
 #include <forward_list>
+#include <fstream>
 
 #define BOOST_UT_DISABLE_MODULE
 #include <boost/ut.hpp>
@@ -1290,10 +1292,442 @@ int main() {
 
   };
 
+  "body receiver"_test = [] {
+    using namespace std::chrono_literals;
+
+    auto req = chttpp::agent{"https://httpbin.org/", { .timeout = 5s }};
+
+    std::size_t received = 0;
+
+    // 型消去を介さない受信コールバック
+    req.get("bytes/1024", [&](std::span<const char> data) { received += data.size(); })
+      .then([&](auto &&response) {
+        ut::expect(response.status_code.OK()) << response.status_code.value();
+        ut::expect(response.body.empty());
+        ut::expect(received == 1024u) << received;
+      }).catch_error([](auto&& ec) {
+        ut::expect(false) << ec.message();
+      });
+
+    // 受信側からの中断
+    auto res = req.request<chttpp::get>("bytes/1024", [](std::span<const char>) { return chttpp::receive_status::abort; });
+
+    ut::expect(not res);
+  };
+
+  "pause and resume"_test = [] {
+    using namespace std::chrono_literals;
+
+    auto req = chttpp::agent{"https://httpbin.org/", { .timeout = 5s }};
+
+    chttpp::flow_control flow;
+    std::size_t received = 0;
+    bool paused = false;
+
+    // 最初のチャンクで一時停止し、再開後に同じデータを受け取る
+    auto res = req.get("bytes/4096", [&](std::span<const char> data) {
+      if (not paused) {
+        paused = true;
+        flow.resume();
+        return chttpp::receive_status::pause;
+      }
+      received += data.size();
+      return chttpp::receive_status::proceed;
+    }, { .flow = &flow });
+
+    ut::expect(bool(res));
+    ut::expect(paused);
+    ut::expect(received == 4096u) << received;
+  };
+
+  "streaming request body"_test = [] {
+    using namespace std::chrono_literals;
+
+    auto req = chttpp::agent{"https://httpbin.org/", { .version = chttpp::cfg_ver::http1_1, .timeout = 5s }};
+
+    // チャンク形式で送信
+    std::vector<std::string> chunks{"chunked", " ", "body"};
+    req.post("post", chunks)
+      .then([](auto&& res) {
+        ut::expect(res.status_code.OK()) << res.status_code.value();
+        ut::expect(res.response_body().find("chunked body") != std::string_view::npos) << res.response_body();
+      }).catch_error([](auto&& ec) {
+        ut::expect(false) << ec.message();
+      });
+
+    // 長さ指定あり
+    req.post("post", chttpp::stream_body(chunks, 12))
+      .then([](auto&& res) {
+        ut::expect(res.status_code.OK()) << res.status_code.value();
+        ut::expect(res.response_body().find("chunked body") != std::string_view::npos) << res.response_body();
+      }).catch_error([](auto&& ec) {
+        ut::expect(false) << ec.message();
+      });
+
+    // 連結せずにセグメントを順に送信
+    std::string payload = "segmented";
+    req.post("post", chttpp::byte_segments(payload, std::string_view{" "}, chunks[2]), { .content_type = "text/plain" })
+      .then([](auto&& res) {
+        ut::expect(res.status_code.OK()) << res.status_code.value();
+        ut::expect(res.response_body().find("segmented body") != std::string_view::npos) << res.response_body();
+      }).catch_error([](auto&& ec) {
+        ut::expect(false) << ec.message();
+      });
+
+    // 307リダイレクトでは、先頭から読み直して再送信する
+    req.post("redirect-to?url=%2Fpost&status_code=307", chunks)
+      .then([](auto&& res) {
+        ut::expect(res.status_code.OK()) << res.status_code.value();
+        ut::expect(res.response_body().find("chunked body") != std::string_view::npos) << res.response_body();
+      }).catch_error([](auto&& ec) {
+        ut::expect(false) << ec.message();
+      });
+  };
+
+  "open_stream"_test = [] {
+    using namespace std::chrono_literals;
+
+    auto req = chttpp::agent{"https://httpbin.org/", { .timeout = 5s }};
+
+    auto stream = req.open_stream("stream-bytes/10000?chunk_size=1000");
+
+    ut::expect(bool(stream)) << stream.error().message();
+    ut::expect(stream.status_code().OK()) << stream.status_code().value();
+
+    std::size_t received = 0;
+    for (std::span<const char> chunk : stream.body()) {
+      ut::expect(not chunk.empty());
+      received += chunk.size();
+    }
+
+    ut::expect(bool(stream));
+    ut::expect(received == 10000u) << received;
+
+    // ムーブ後のストリームは無効
+    auto moved = std::move(stream);
+    ut::expect(bool(moved));
+    ut::expect(not bool(stream));
+    ut::expect(bool(stream.error()));
+    ut::expect(stream.status_code().value() == 0);
+    ut::expect(stream.response_headers().empty());
+    ut::expect(stream.response_header("content-type").empty());
+    ut::expect(std::ranges::empty(stream.body()));
+  };
+
+  "sinks"_test = [] {
+    using namespace std::chrono_literals;
+
+    auto req = chttpp::agent{"https://httpbin.org/", { .timeout = 5s }};
+
+    const auto path = std::filesystem::temp_directory_path() / "chttpp_sinks_test.bin";
+    chttpp::sinks::file_sink file{path};
+    chttpp::sinks::sha256_sink sha{};
+    std::string body{};
+
+    // 1度の受信で、ファイルへの書き込みとハッシュの計算を同時に行う
+    auto result = req.get("bytes/5000?seed=1", chttpp::sinks::tee(file, sha, [&body](std::span<const char> chunk) { body.append(chunk.data(), chunk.size()); }));
+    file.close();
+
+    ut::expect(bool(result) >> ut::fatal);
+    ut::expect(file.bytes_written() == 5000u);
+    ut::expect(std::filesystem::file_size(path) == 5000u);
+
+    chttpp::digest::sha256 expected{};
+    expected.update(body);
+    ut::expect(sha.value() == expected.value());
+
+    // httpbinはDigest系ヘッダを返さない
+    ut::expect(sha.verify(result.value()) == chttpp::sinks::digest_check::absent);
+
+    std::filesystem::remove(path);
+  };
+
+  "json view"_test = [] {
+    using namespace std::chrono_literals;
+
+    auto req = chttpp::agent{"https://httpbin.org/", { .timeout = 5s }};
+
+    auto res = req.get("json");
+    ut::expect(bool(res) >> ut::fatal);
+
+    // レスポンスボディを直接参照し、必要な部分だけを読む
+    const auto json = res | chttpp::as_json;
+    ut::expect(json["slideshow"]["author"].as_string_view() == "Yours Truly");
+    ut::expect(json["slideshow"]["slides"][1]["items"][0].as_string() == "Why <em>WonderWidgets</em> are great");
+    ut::expect(not json["slideshow"]["missing"]);
+  };
+
+  "form body"_test = [] {
+    using namespace std::chrono_literals;
+    using namespace std::string_view_literals;
+
+    auto req = chttpp::agent{"https://httpbin.org/", { .timeout = 5s }};
+
+    auto res = req.post("post", chttpp::form_body{{"name", "John Doe"}, {"q", "a&b=c"}});
+    ut::expect(bool(res) >> ut::fatal);
+    ut::expect(res.status_code().OK()) << res.status_code().value();
+
+    const auto json = res | chttpp::as_json;
+    ut::expect(json["headers"]["Content-Type"].as_string_view() == "application/x-www-form-urlencoded");
+    ut::expect(json["form"]["name"].as_string_view() == "John Doe");
+    ut::expect(json["form"]["q"].as_string_view() == "a&b=c");
+  };
+
+#ifndef _MSC_VER
+  // 以下はlibcurl実装でのみ利用可能な機能のテスト
+  "download"_test = [] {
+    using namespace std::chrono_literals;
+
+    auto req = chttpp::agent{"https://httpbin.org/", { .timeout = 5s }};
+    const auto path = std::filesystem::temp_directory_path() / "chttpp_download_test.bin";
+    std::filesystem::remove(path);
+
+    req.download("range/1000", path)
+      .then([&](auto&& res) {
+        ut::expect(res.status_code.OK()) << res.status_code.value();
+        ut::expect(res.body.empty());
+        ut::expect(std::filesystem::file_size(path) == 1000u);
+      }).catch_error([](auto&& ec) {
+        ut::expect(false) << ec.message();
+      });
+
+    // 途中までのファイルから続きを取得する
+    std::filesystem::resize_file(path, 400);
+
+    req.download("range/1000", path)
+      .then([&](auto&& res) {
+        ut::expect(res.status_code == 206) << res.status_code.value();
+        ut::expect(std::filesystem::file_size(path) == 1000u);
+      }).catch_error([](auto&& ec) {
+        ut::expect(false) << ec.message();
+      });
+
+    std::filesystem::remove(path);
+  };
+
+  "parallel download"_test = [] {
+    using namespace std::chrono_literals;
+
+    const auto path = std::filesystem::temp_directory_path() / "chttpp_parallel_download_test.bin";
+
+    chttpp::parallel_download("https://httpbin.org/range/4000", path, { .parts = 4, .min_part_size = 1000 }, { .timeout = 5s })
+      .then([&](auto&& res) {
+        ut::expect(res.status_code.OK()) << res.status_code.value();
+        ut::expect(std::filesystem::file_size(path) == 4000u);
+
+        // /range/nは、a-zを繰り返したボディを返す
+        std::ifstream file{path, std::ios::binary};
+        std::string content{std::istreambuf_iterator<char>{file}, {}};
+        ut::expect(content.size() == 4000u);
+        ut::expect(content.substr(1000, 4) == "mnop") << content.substr(1000, 4);
+      }).catch_error([](auto&& ec) {
+        ut::expect(false) << ec.message();
+      });
+
+    std::filesystem::remove(path);
+  };
+
+  "remote file"_test = [] {
+    using namespace std::chrono_literals;
+
+    auto req = chttpp::agent{"https://httpbin.org/", { .timeout = 5s }};
+    chttpp::remote_file file{req, "range/2000", { .block_size = 256, .cache_blocks = 4 }};
+
+    // /range/nは、a-zを繰り返したボディを返す
+    const auto tail = file.read(1990, 20);
+    ut::expect(bool(file)) << file.error().message();
+    ut::expect(tail.size() == 10u) << tail.size();
+    ut::expect(std::string_view{tail.data(), tail.size()} == "opqrstuvwx");
+
+    ut::expect(file.size() == 2000u);
+
+    char buffer[300];
+    ut::expect(file.read(0, buffer) == 300u);
+    ut::expect(std::string_view{buffer, 4} == "abcd");
+    ut::expect(file.cached_blocks() <= 4u);
+  };
+
+  "tail"_test = [] {
+    using namespace std::chrono_literals;
+
+    auto req = chttpp::agent{"https://httpbin.org/", { .timeout = 5s }};
+
+    // 初回は全体を取得する
+    req.tail("range/100")
+      .then([](auto&& res) {
+        ut::expect(res.status_code.OK()) << res.status_code.value();
+        ut::expect(res.body.size() == 100u);
+      }).catch_error([](auto&& ec) {
+        ut::expect(false) << ec.message();
+      });
+
+    // 追記されていないので、ボディは空
+    req.tail("range/100")
+      .then([](auto&& res) {
+        ut::expect(res.status_code == 416) << res.status_code.value();
+        ut::expect(res.body.empty());
+      }).catch_error([](auto&& ec) {
+        ut::expect(false) << ec.message();
+      });
+
+    // 状態を破棄すると、再び全体を取得する
+    req.reset_tail("range/100");
+    req.tail("range/100")
+      .then([](auto&& res) {
+        ut::expect(res.status_code.OK()) << res.status_code.value();
+        ut::expect(res.body.size() == 100u);
+      }).catch_error([](auto&& ec) {
+        ut::expect(false) << ec.message();
+      });
+  };
+
+  "body budget"_test = [] {
+    using namespace std::chrono_literals;
+
+    auto req = chttpp::agent{"https://httpbin.org/", { .timeout = 5s, .budget = { .spill_threshold = 1024 } }};
+
+    // 閾値を超えるボディは一時ファイルに保持されるが、アクセス方法は変わらない
+    req.get("bytes/5000")
+      .then([](auto&& res) {
+        ut::expect(res.status_code.OK()) << res.status_code.value();
+        ut::expect(res.response_data().size() == 5000u);
+      }).catch_error([](auto&& ec) {
+        ut::expect(false) << ec.message();
+      });
+
+    // Content-Lengthが上限を超える
+    auto result = req.get("bytes/5000", { .budget = { .max_body_size = 1000 } });
+    ut::expect(not result);
+
+    // Content-Lengthがない場合も、受信中に上限を超えた時点で中断する
+    auto chunked = req.get("stream-bytes/5000?chunk_size=500", { .budget = { .max_body_size = 1000 } });
+    ut::expect(not chunked);
+  };
+
+  "response inspector"_test = [] {
+    using namespace std::chrono_literals;
+
+    auto req = chttpp::agent{"https://httpbin.org/", { .timeout = 5s }};
+
+    // ボディ受信前にステータスとヘッダを確認できる
+    req.get("bytes/5000", { .inspector = [](const chttpp::response_head& head) {
+        ut::expect(head.status == 200u);
+        ut::expect(head.content_length == 5000u);
+        ut::expect(head.header("content-type") == "application/octet-stream");
+        return chttpp::body_action::keep(*head.content_length);
+      }})
+      .then([](auto&& res) {
+        ut::expect(res.status_code.OK()) << res.status_code.value();
+        ut::expect(res.response_data().size() == 5000u);
+      }).catch_error([](auto&& ec) {
+        ut::expect(false) << ec.message();
+      });
+
+    // 大きすぎるボディは受信せずに中断する
+    auto aborted = req.get("bytes/5000", { .inspector = [](const chttpp::response_head& head) {
+        return head.content_length.value_or(0) < 1000u ? chttpp::body_action::keep() : chttpp::body_action::abort();
+      }});
+    ut::expect(not aborted);
+
+    // ボディを捨てる
+    req.get("status/404", { .inspector = [](const chttpp::response_head& head) {
+        return head.status == 200u ? chttpp::body_action::keep() : chttpp::body_action::discard();
+      }})
+      .then([](auto&& res) {
+        ut::expect(res.status_code == 404);
+        ut::expect(res.response_data().empty());
+      }).catch_error([](auto&& ec) {
+        ut::expect(false) << ec.message();
+      });
+
+    // リダイレクトに追従する場合、呼ばれるのは最終的なレスポンスに対してのみ
+    int count = 0;
+    auto redirected = req.get("redirect/2", { .inspector = [&count](const chttpp::response_head& head) {
+        ++count;
+        ut::expect(head.status == 200u);
+        return chttpp::body_action::keep();
+      }});
+    ut::expect(bool(redirected));
+    ut::expect(count == 1);
+
+    // ボディをファイルへ直接書き出す
+    const auto path = std::filesystem::temp_directory_path() / "chttpp_inspector_test.bin";
+    auto to_file = req.get("bytes/5000", { .inspector = [&path](const chttpp::response_head&) {
+        return chttpp::body_action::to_file(path);
+      }});
+    ut::expect(bool(to_file));
+    ut::expect(std::filesystem::file_size(path) == 5000u);
+    std::filesystem::remove(path);
+  };
+
+  "event stream"_test = [] {
+    using namespace std::chrono_literals;
+
+    auto req = chttpp::agent{"https://httpbin.org/", { .timeout = 5s }};
+
+    // text/event-streamではないレスポンスはイベントとして扱わず、再接続もしない
+    int events = 0;
+    auto result = req.event_stream("json", [&events](const chttpp::sse_event&) { ++events; }, { .retry = 10ms });
+
+    ut::expect(bool(result) >> ut::fatal);
+    ut::expect(result.status_code().OK());
+    ut::expect(events == 0);
+
+    // 200以外の場合も終了する
+    auto not_found = req.event_stream("status/404", [](const chttpp::sse_event&) {});
+    ut::expect(bool(not_found) >> ut::fatal);
+    ut::expect(not_found.status_code() == 404);
+  };
+
+  "multipart form"_test = [] {
+    using namespace std::chrono_literals;
+    using namespace std::string_view_literals;
+
+    const auto path = std::filesystem::temp_directory_path() / "chttpp_multipart_test.txt";
+    {
+      std::ofstream file{path, std::ios::binary};
+      file << "file content";
+    }
+
+    std::string payload = "payload";
+    int count = 0;
+
+    chttpp::multipart form;
+    form.add("field", "value"sv)
+        .add("data", payload, { .filename = "data.bin", .content_type = "application/octet-stream" })
+        .add_file("upload", path)
+        .add_stream("stream", [&count](std::span<char> buffer) -> std::size_t {
+          if (3 <= count) return 0;
+          buffer[0] = "abc"[count++];
+          return 1;
+        });
+
+    auto req = chttpp::agent{"https://httpbin.org/", { .version = chttpp::cfg_ver::http1_1, .timeout = 5s }};
+    auto res = req.post("post", form);
+
+    std::filesystem::remove(path);
+
+    ut::expect(bool(res) >> ut::fatal);
+    ut::expect(res.status_code().OK()) << res.status_code().value();
+
+    const auto json = res | chttpp::as_json;
+    ut::expect(json["headers"]["Content-Type"].as_string_view().value_or("").starts_with("multipart/form-data; boundary="));
+    ut::expect(json["form"]["field"].as_string_view() == "value");
+    ut::expect(json["form"]["stream"].as_string_view() == "abc");
+    ut::expect(json["files"]["upload"].as_string_view() == "file content");
+    ut::expect(json["files"]["data"].as_string_view() == "payload");
+  };
+#endif
+
   underlying_test();
   http_result_test();
   http_config_test();
   status_code_test();
   cookie_test();
   exptr_wrapper_test();
+  streaming_receiver_test();
+  request_body_test();
+  range_request_test();
+  sinks_test();
+  json_view_test();
 }
\ No newline at end of file
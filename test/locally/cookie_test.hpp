@@ -810,7 +810,151 @@ void cookie_test() {
       ut::expect(ui3.full_url() == "https://httpbin.org/redirect-to");
     }
     ut::expect(ui3.request_path() == "/");
+    {
+      // パスが空
+      [[maybe_unused]]
+      auto token = ui3.append_path("");
+      ut::expect(ui3.full_url() == "https://httpbin.org/");
+    }
+
+    // URLパラメータはエンコードしてクエリに付加される
+    const std::array<std::pair<std::string_view, std::string_view>, 2> params{{ {"a b", "c&d"}, {"e", "f"} }};
+    {
+      [[maybe_unused]]
+      auto token = ui3.append_path("/get", params);
+      ut::expect(ui3.request_path() == "/get");
+      ut::expect(ui3.request_query() == "a+b=c%26d&e=f");
+      ut::expect(ui3.full_url() == "https://httpbin.org/get?a+b=c%26d&e=f");
+    }
+    ut::expect(ui3.full_url() == "https://httpbin.org/");
+    {
+      // 既存のクエリには&で繋ぐ、アンカーは無視される
+      [[maybe_unused]]
+      auto token = ui3.append_path("/get?x=1#anchor", params);
+      ut::expect(ui3.full_url() == "https://httpbin.org/get?x=1&a+b=c%26d&e=f");
+    }
+    ut::expect(ui3.full_url() == "https://httpbin.org/");
+  };
+
+  "route"_test = [] {
+    using chttpp::detail::url_info;
+
+    static_assert(chttpp::route<"/users/{}/repos/{}">.arity == 2);
+    static_assert(chttpp::route<"/health">.arity == 0);
+    static_assert(chttpp::route<"/users/{}">.label() == "/users/{}");
+
+    // 整数は標準の整数型のみ、文字型は埋め込めない
+    static_assert(chttpp::detail::route_argument<std::uint8_t> and chttpp::detail::route_argument<long long>);
+    static_assert(not chttpp::detail::route_argument<bool>);
+    static_assert(not chttpp::detail::route_argument<char> and not chttpp::detail::route_argument<wchar_t>);
+    static_assert(not chttpp::detail::route_argument<char8_t> and not chttpp::detail::route_argument<char16_t> and not chttpp::detail::route_argument<char32_t>);
+#ifdef __SIZEOF_INT128__
+    static_assert(not chttpp::detail::route_argument<__int128_t>);
+#endif
+
+    const std::string name = "a b/c";
+    const int id = -42;
 
+    auto r = chttpp::route<"/users/{}/repos/{}">(id, name);
+    ut::expect(r.label() == "/users/{}/repos/{}");
+    // 文字列はパス用にエンコードされる（スペースは%20、/も%2Fになる）
+    ut::expect(r.str() == "/users/-42/repos/a%20b%2Fc");
+    ut::expect(chttpp::route<"/{}/{}/{}">(18446744073709551615ull, "\xC3\xA9", "-._~").str() == "/18446744073709551615/%C3%A9/-._~");
+    ut::expect(chttpp::route<"/empty/{}">("").str() == "/empty/");
+
+    url_info ui{"https://example.com/api/"};
+    {
+      [[maybe_unused]]
+      auto token = ui.append_path(r);
+      ut::expect(ui.full_url() == "https://example.com/api/users/-42/repos/a%20b%2Fc");
+    }
+    ut::expect(ui.full_url() == "https://example.com/api/");
+    {
+      const std::array<std::pair<std::string_view, std::string_view>, 1> params{{ {"q", "1 2"} }};
+
+      [[maybe_unused]]
+      auto token = ui.append_path(chttpp::route<"/search/{}">("x?y"), params);
+      ut::expect(ui.request_path() == "/api/search/x%3Fy");
+      ut::expect(ui.request_query() == "q=1+2");
+    }
+    {
+      // 引数の無いルートはそのまま使用できる
+      [[maybe_unused]]
+      auto token = ui.append_path(chttpp::route<"/health">);
+      ut::expect(ui.full_url() == "https://example.com/api/health");
+    }
+  };
+
+  "url_info::normalize()"_test = [] {
+    using chttpp::detail::url_info;
+
+    const auto normalize = [](std::string_view url, chttpp::detail::url_normalize_config cfg = {}) {
+      return url_info{url}.normalize(cfg);
+    };
+
+    // スキームとホストの小文字化、デフォルトポートの省略
+    ut::expect(normalize("HTTP://User@Example.COM:80/Path").url == "http://User@example.com/Path");
+    ut::expect(normalize("https://example.com:443").url == "https://example.com/");
+    ut::expect(normalize("https://example.com:0443/").url == "https://example.com/");
+    ut::expect(normalize("https://example.com:80/").url == "https://example.com:80/");
+    ut::expect(normalize("http://example.com:/").url == "http://example.com/");
+    ut::expect(normalize("http://[FE80::1]:80/").url == "http://[fe80::1]/");
+    ut::expect(normalize("http://[::1]:8080/").url == "http://[::1]:8080/");
+    // スキームが無い場合はhttps
+    ut::expect(normalize("example.com").url == "https://example.com/");
+
+    // パーセントエンコーディングの正規化（非予約文字はデコード、それ以外は大文字）
+    ut::expect(normalize("https://example.com/%7euser/%2f%41?q=%3d").url == "https://example.com/~user/%2FA?q=%3D");
+    // 不正な%はそのまま
+    ut::expect(normalize("https://example.com/%zz%4").url == "https://example.com/%zz%4");
+
+    // ドットセグメントの除去（RFC 3986 5.2.4の例）
+    ut::expect(normalize("http://example.com/a/b/c/./../../g").url == "http://example.com/a/g");
+    ut::expect(normalize("http://example.com/mid/content=5/../6").url == "http://example.com/mid/6");
+    ut::expect(normalize("http://example.com/a/..").url == "http://example.com/");
+    ut::expect(normalize("http://example.com/a/.").url == "http://example.com/a/");
+    ut::expect(normalize("http://example.com/../../x").url == "http://example.com/x");
+    ut::expect(normalize("http://example.com/%2E%2E/x/%2e/y").url == "http://example.com/x/y");
+
+    // フラグメントは取り除く
+    ut::expect(normalize("https://example.com/p?a=1#frag").url == "https://example.com/p?a=1");
+
+    // クエリのソート（同名パラメータの順序は保つ）
+    ut::expect(normalize("https://example.com/?b=2&a=1&&a=0").url == "https://example.com/?b=2&a=1&&a=0");
+    ut::expect(normalize("https://example.com/?b=2&a=1&&a=0", {.sort_query = true}).url == "https://example.com/?a=1&a=0&b=2");
+    ut::expect(normalize("https://example.com/?ab=1&a=2", {.sort_query = true}).url == "https://example.com/?a=2&ab=1");
+
+    // 無効なURL
+    ut::expect(normalize("").url.empty());
+    ut::expect(normalize("").fingerprint == 0u);
+
+    // フィンガープリントは、正規化結果が等しければ一致する
+    const auto n1 = normalize("HTTPS://Example.com:443/a/../b/%7e?y=2&x=1#top", {.sort_query = true});
+    const auto n2 = normalize("https://example.com/b/~?x=1&y=2", {.sort_query = true});
+    ut::expect(n1.url == n2.url);
+    ut::expect(n1.fingerprint == n2.fingerprint);
+    ut::expect(n1.fingerprint != normalize("https://example.com/b/~?x=1&y=3").fingerprint);
+    ut::expect(n1.fingerprint != normalize("http://example.com/b/~?x=1&y=2").fingerprint);
+
+    // 正規化済みのURLは変化しない
+    const auto again = normalize(n1.url, {.sort_query = true});
+    ut::expect(again.url == n1.url);
+    ut::expect(again.fingerprint == n1.fingerprint);
+
+    // フィンガープリントは入力の区切り方によらない
+    {
+      chttpp::detail::fingerprint64 whole{};
+      whole.update(n1.url);
+
+      chttpp::detail::fingerprint64 split{};
+      const std::string_view url = n1.url;
+      split.update(url.substr(0, 3));
+      split.update(url.substr(3, 10));
+      split.update(url.substr(13));
+
+      ut::expect(whole.value() == n1.fingerprint);
+      ut::expect(split.value() == n1.fingerprint);
+    }
   };
 
   "agent test check"_test = [] {
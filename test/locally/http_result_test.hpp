@@ -40,6 +40,15 @@ auto hr_ok_range() -> chttpp::http_result {
   return chttpp::http_result{chttpp::detail::http_response{{}, std::move(bytes), {{"http-status-line", "HTTP/1.1 200 OK"}}, chttpp::detail::http_status_code{200}}};
 }
 
+auto hr_ok_u32_be() -> chttpp::http_result {
+  auto bytes = chttpp::detail::make_response_body();
+  // ビッグエンディアンの 1, 2, 0x01020304
+  for (unsigned char c : {0, 0, 0, 1, 0, 0, 0, 2, 1, 2, 3, 4}) {
+    bytes.push_back(static_cast<char>(c));
+  }
+  return chttpp::http_result{chttpp::detail::http_response{{}, std::move(bytes), {{"http-status-line", "HTTP/1.1 200 OK"}}, chttpp::detail::http_status_code{200}}};
+}
+
 void http_result_test() {
   using namespace boost::ut::literals;
   using namespace boost::ut::operators::terse;
@@ -309,6 +318,45 @@ void http_result_test() {
     }
   };
 
+  "response_data alignment"_test = [] {
+    auto body = chttpp::detail::make_response_body();
+    body.resize(3);
+
+    ut::expect(reinterpret_cast<std::uintptr_t>(body.data()) % chttpp::detail::response_body_alignment == 0_ull);
+  };
+
+  "response_data endian"_test = [] {
+    auto hr = hr_ok_u32_be();
+
+    auto data = hr.response_data<std::uint32_t>(std::endian::big);
+
+    ut::expect(data.size() == 3_ull);
+    ut::expect(data[0] == 1u);
+    ut::expect(data[1] == 2u);
+    ut::expect(data[2] == 0x01020304u);
+
+    // 繰り返し呼んでも、受信したデータを基準に変換される
+    auto again = hr.response_data<std::uint32_t>(std::endian::big);
+    ut::expect(again[0] == 1u);
+    ut::expect(again[2] == 0x01020304u);
+
+    // 実行環境のバイトオーダーを指定すると、受信したままのデータが見える
+    auto raw = hr.response_data<std::uint32_t>(std::endian::native);
+    ut::expect(raw[2] == std::bit_cast<std::uint32_t>(std::array<unsigned char, 4>{1, 2, 3, 4}));
+
+    // 要素サイズを変えても、受信したデータが基準になる
+    auto u16 = hr.response_data<std::uint16_t>(std::endian::big);
+    ut::expect(u16[1] == 1u);
+    ut::expect(u16[5] == 0x0304u);
+    ut::expect(hr.response_data<std::uint32_t>(std::endian::big)[2] == 0x01020304u);
+
+    double d[] = { 1.5, -2.25 };
+    chttpp::detail::byteswap_in_place(std::span<double>{d});
+    chttpp::detail::byteswap_in_place(std::span<double>{d});
+    ut::expect(d[0] == 1.5);
+    ut::expect(d[1] == -2.25);
+  };
+
   "http_result |"_test = [] {
     auto hr = hr_ok_range();
 
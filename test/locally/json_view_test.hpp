@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <ranges>
+
+#include "chttpp.hpp"
+#include "json_view.hpp"
+
+#define BOOST_UT_DISABLE_MODULE
+#include <boost/ut.hpp>
+
+void json_view_test() {
+  using namespace boost::ut::literals;
+  using namespace boost::ut::operators::terse;
+  namespace ut = boost::ut;
+  using namespace std::string_view_literals;
+  using chttpp::json::kind;
+
+  "json value access"_test = [] {
+    constexpr auto text = R"(  {"id": 12, "name": "chttpp", "ratio": -1.5e3, "ok": true, "none": null,
+                             "tags": ["a", "b\"c", {"k": [1, 2]}], "nested": {"inner": {"value": "x"}}}  )"sv;
+
+    const auto root = chttpp::json::parse(text);
+
+    ut::expect(root.type() == kind::object);
+    ut::expect(root["id"].as_int() == 12);
+    ut::expect(root["name"].as_string_view() == "chttpp"sv);
+    ut::expect(root["ratio"].as_double() == -1500.0);
+    ut::expect(root["ok"].as_bool() == true);
+    ut::expect(root["none"].is_null());
+    ut::expect(root["nested"]["inner"]["value"].as_string_view() == "x"sv);
+
+    // 元の文字列を参照する
+    const auto name = *root["name"].as_string_view();
+    ut::expect(text.data() <= name.data() and name.data() < text.data() + text.size());
+
+    const auto tags = root["tags"];
+    ut::expect(tags.type() == kind::array);
+    ut::expect(tags[0].as_string_view() == "a"sv);
+    ut::expect(tags[2]["k"][1].as_int() == 2);
+    ut::expect(std::ranges::distance(tags.elements()) == 3);
+
+    // エスケープを含む文字列はas_string()で展開する
+    ut::expect(not tags[1].as_string_view().has_value());
+    ut::expect(tags[1].as_string() == "b\"c");
+
+    std::vector<std::string_view> keys{};
+    for (const auto& member : root.members()) {
+      keys.push_back(member.key);
+    }
+    ut::expect(keys == std::vector{"id"sv, "name"sv, "ratio"sv, "ok"sv, "none"sv, "tags"sv, "nested"sv});
+
+    // 存在しない要素とその先は全てinvalid
+    ut::expect(root["missing"].type() == kind::invalid);
+    ut::expect(root["missing"]["a"][0].type() == kind::invalid);
+    ut::expect(not root["tags"][3]);
+    ut::expect(not root["id"]["x"]);
+    ut::expect(not root["name"].as_int().has_value());
+    ut::expect(not root["id"].as_string().has_value());
+  };
+
+  "json string unescape"_test = [] {
+    const auto root = chttpp::json::parse(R"({"s": "tab\tnl\n\u00e9\ud83d\ude00\/", "k\"ey": 1, "bad": "\x"})");
+
+    ut::expect(root["s"].as_string() == "tab\tnl\n\xC3\xA9\xF0\x9F\x98\x80/");
+    // エスケープされたキーも探索できる
+    ut::expect(root["k\"ey"].as_int() == 1);
+    ut::expect(not root["bad"].as_string().has_value());
+  };
+
+  "json malformed"_test = [] {
+    ut::expect(chttpp::json::parse("").type() == kind::invalid);
+    ut::expect(chttpp::json::parse("  ").type() == kind::invalid);
+
+    // 閉じていない配列の要素には到達できない
+    const auto root = chttpp::json::parse(R"({"a": 1, "b": [1, 2)");
+    ut::expect(root["a"].as_int() == 1);
+    ut::expect(not root["b"]);
+  };
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+#include <span>
+
+#include "chttpp.hpp"
+
+#define BOOST_UT_DISABLE_MODULE
+#include <boost/ut.hpp>
+
+void range_request_test() {
+  using namespace boost::ut::literals;
+  using namespace boost::ut::operators::terse;
+  namespace ut = boost::ut;
+
+  "parse content range"_test = [] {
+    using chttpp::detail::parse_content_range;
+    using chttpp::detail::content_range;
+
+    {
+      const auto range = parse_content_range("bytes 100-199/1000");
+      ut::expect(range.has_value() >> ut::fatal);
+      ut::expect(range->has_range);
+      ut::expect(range->first == 100u);
+      ut::expect(range->last == 199u);
+      ut::expect(range->length == 1000u);
+    }
+    {
+      // 全体の長さが不明
+      const auto range = parse_content_range("bytes 0-9/*");
+      ut::expect(range.has_value() >> ut::fatal);
+      ut::expect(range->has_range);
+      ut::expect(range->length == content_range::unknown_length);
+    }
+    {
+      // 416の場合
+      const auto range = parse_content_range("bytes */1234");
+      ut::expect(range.has_value() >> ut::fatal);
+      ut::expect(not range->has_range);
+      ut::expect(range->length == 1234u);
+    }
+
+    ut::expect(not parse_content_range(""));
+    ut::expect(not parse_content_range("bytes */*"));
+    ut::expect(not parse_content_range("bytes 10-5/100"));
+    ut::expect(not parse_content_range("bytes 1-2"));
+    ut::expect(not parse_content_range("items 1-2/3"));
+    ut::expect(not parse_content_range("bytes 1x-2/3"));
+  };
+
+  "block cache"_test = [] {
+    chttpp::detail::block_cache cache{2};
+
+    const std::vector<char> a{'a', 'a'}, b{'b'}, c{'c', 'c', 'c'};
+
+    cache.insert(0, a);
+    cache.insert(1, b);
+    ut::expect(cache.size() == 2u);
+
+    // 0を使用したので、1が追い出される
+    ut::expect(cache.find(0) != nullptr);
+    cache.insert(2, c);
+
+    ut::expect(cache.size() == 2u);
+    ut::expect(cache.contains(0));
+    ut::expect(not cache.contains(1));
+    ut::expect(cache.contains(2));
+
+    const auto* block = cache.find(2);
+    ut::expect((block != nullptr) >> ut::fatal);
+    ut::expect(std::ranges::equal(*block, c));
+
+    // 同じブロックの上書きでは追い出されない
+    cache.insert(2, b);
+    ut::expect(cache.size() == 2u);
+    ut::expect(std::ranges::equal(*cache.find(2), b));
+
+    cache.clear();
+    ut::expect(cache.size() == 0u);
+    ut::expect(cache.find(0) == nullptr);
+
+    // 容量0は1として扱う
+    chttpp::detail::block_cache tiny{0};
+    ut::expect(tiny.capacity() == 1u);
+  };
+}
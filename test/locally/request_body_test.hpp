@@ -0,0 +1,271 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <span>
+#include <cstdint>
+#include <ranges>
+#include <fstream>
+#include <filesystem>
+
+#include "chttpp.hpp"
+
+#define BOOST_UT_DISABLE_MODULE
+#include <boost/ut.hpp>
+
+void request_body_test() {
+  using namespace boost::ut::literals;
+  using namespace boost::ut::operators::terse;
+  namespace ut = boost::ut;
+
+  // body_readerから全て読み出す
+  auto read_all = [](chttpp::detail::body_reader& reader, std::size_t buffer_len) {
+    std::string result;
+    std::vector<char> buffer(buffer_len);
+
+    while (true) {
+      const std::size_t len = reader.read(buffer);
+      if (len == 0) break;
+      result.append(buffer.data(), len);
+    }
+
+    return result;
+  };
+
+  "body_source concept"_test = [] {
+    static_assert(chttpp::byte_chunk_range<std::vector<std::string>>);
+    static_assert(chttpp::byte_chunk_range<std::vector<std::string_view>>);
+    static_assert(not chttpp::byte_chunk_range<std::string>);
+    static_assert(not chttpp::byte_chunk_range<std::vector<char>>);
+
+    static_assert(chttpp::body_source<decltype([](std::span<char>) -> std::size_t { return 0; })>);
+    static_assert(not chttpp::body_source<decltype([](std::span<const char>) {})>);
+    static_assert(chttpp::body_source<chttpp::detail::body_reader>);
+  };
+
+  "chunk range reader"_test = [read_all] {
+    std::vector<std::string> chunks{"abc", "", "defgh", "i"};
+
+    // バッファより小さいチャンク、大きいチャンク、空のチャンク
+    for (std::size_t buffer_len : {1u, 2u, 4u, 64u}) {
+      auto reader = chttpp::detail::make_body_reader(chunks);
+
+      ut::expect(not reader.has_length());
+      ut::expect(read_all(reader, buffer_len) == "abcdefghi") << buffer_len;
+    }
+
+    // 要素が一時オブジェクトとなる範囲
+    auto gen = std::views::iota(0, 3) | std::views::transform([](int n) { return std::string(3, char('x' + n)); });
+    auto reader = chttpp::stream_body(gen, 9);
+
+    ut::expect(reader.has_length());
+    ut::expect(reader.length() == 9_u);
+    ut::expect(read_all(reader, 4) == "xxxyyyzzz");
+  };
+
+  "read function"_test = [read_all] {
+    std::string_view source = "0123456789";
+
+    auto reader = chttpp::stream_body([&](std::span<char> buffer) -> std::size_t {
+      const auto len = std::min(buffer.size(), source.size());
+      source.copy(buffer.data(), len);
+      source.remove_prefix(len);
+      return len;
+    });
+
+    ut::expect(read_all(reader, 3) == "0123456789");
+
+    // 読み出し関数は読み直せない
+    ut::expect(not reader.can_seek());
+    ut::expect(not reader.seek(0));
+  };
+
+  "body_reader seek"_test = [read_all] {
+    // 先頭から辿り直せるチャンクの範囲は、読み直せる
+    std::vector<std::string> chunks{"abc", "", "defgh", "i"};
+    auto reader = chttpp::detail::make_body_reader(chunks);
+
+    ut::expect(reader.can_seek());
+    ut::expect(read_all(reader, 4) == "abcdefghi");
+    ut::expect(reader.seek(0));
+    ut::expect(read_all(reader, 2) == "abcdefghi");
+    ut::expect(reader.seek(4));
+    ut::expect(read_all(reader, 64) == "efghi");
+    // 範囲外
+    ut::expect(not reader.seek(10));
+
+    // セグメント
+    auto segs = chttpp::byte_segments(std::string_view{"head"}, std::string_view{"body"});
+    auto seg_reader = chttpp::detail::make_body_reader(segs);
+    ut::expect(read_all(seg_reader, 3) == "headbody");
+    ut::expect(seg_reader.seek(2));
+    ut::expect(read_all(seg_reader, 3) == "adbody");
+  };
+
+  "byte segments"_test = [read_all] {
+    struct header {
+      std::uint32_t magic;
+      std::uint32_t length;
+    };
+
+    // as_byte_segments()を持つ型
+    struct message {
+      header head;
+      std::string payload;
+      std::string_view trailer;
+
+      auto as_byte_segments() const -> std::array<std::span<const char>, 3> {
+        return { chttpp::cpo::as_byte_seq(head), std::span<const char>(payload), std::span<const char>(trailer) };
+      }
+    };
+
+    static_assert(chttpp::byte_segmentable<message>);
+    static_assert(chttpp::body_source<message>);
+    static_assert(not chttpp::byte_serializable<message>);
+
+    const message msg{ {0x12345678, 5}, "hello", "\r\n" };
+    std::string expected(reinterpret_cast<const char*>(&msg.head), sizeof(header));
+    expected += "hello\r\n";
+
+    for (std::size_t buffer_len : {1u, 3u, 64u}) {
+      auto reader = chttpp::detail::make_body_reader(msg);
+
+      // セグメントの長さの合計がボディの長さになる
+      ut::expect(reader.has_length());
+      ut::expect(reader.length() == expected.size());
+      ut::expect(read_all(reader, buffer_len) == expected) << buffer_len;
+    }
+
+    // byte_segments()ヘルパ
+    const header head{0xabcdef01, 4};
+    const std::vector<char> payload{'d', 'a', 't', 'a'};
+    auto segs = chttpp::byte_segments(head, payload, std::string_view{"end"});
+
+    static_assert(chttpp::body_source<decltype(segs)>);
+    static_assert(not chttpp::byte_serializable<decltype(segs)>);
+
+    auto reader = chttpp::detail::make_body_reader(segs);
+    ut::expect(reader.length() == sizeof(header) + 7);
+    ut::expect(read_all(reader, 5).substr(sizeof(header)) == "dataend");
+  };
+
+  "content type from extension"_test = [] {
+    using chttpp::detail::content_type_from_extension;
+
+    ut::expect(content_type_from_extension("json") == "application/json");
+    ut::expect(content_type_from_extension("PNG") == "image/png");
+    ut::expect(content_type_from_extension("html") == "text/html");
+    ut::expect(content_type_from_extension("ico") == "image/vnd.microsoft.icon");
+    ut::expect(content_type_from_extension("svg") == std::string_view{chttpp::mime_types::image/chttpp::mime_types::svg+chttpp::mime_types::xml});
+    ut::expect(content_type_from_extension("unknown").empty());
+    ut::expect(content_type_from_extension("").empty());
+  };
+
+#ifndef _MSC_VER
+  "file_body"_test = [read_all] {
+    const auto path = std::filesystem::temp_directory_path() / "chttpp_file_body_test.txt";
+    const std::string content(100000, 'f');
+    {
+      std::ofstream ofs{path, std::ios::binary};
+      ofs << content;
+    }
+
+    // mmapされる
+    {
+      chttpp::file_body body{path};
+
+      ut::expect(bool(body));
+      ut::expect(body.mapped());
+      ut::expect(body.size() == content.size());
+      ut::expect(body.content_type() == "text/plain");
+
+      auto reader = body.as_body_reader();
+      ut::expect(reader.length() == content.size());
+      ut::expect(reader.contiguous().size() == content.size());
+    }
+
+    // 閾値を超えるのでpreadで読み出される
+    {
+      chttpp::file_body body{path, 1024};
+
+      ut::expect(not body.mapped());
+
+      auto reader = body.as_body_reader();
+      ut::expect(reader.length() == content.size());
+      ut::expect(reader.contiguous().empty());
+      ut::expect(read_all(reader, 4096) == content);
+
+      // 再送信のために読み直せる
+      ut::expect(reader.can_seek());
+      ut::expect(reader.seek(content.size() - 10));
+      ut::expect(read_all(reader, 4096) == content.substr(content.size() - 10));
+      ut::expect(not reader.seek(content.size() + 1));
+    }
+
+    std::filesystem::remove(path);
+
+    // 存在しないファイル
+    chttpp::file_body missing{path};
+    ut::expect(not missing);
+    ut::expect(missing.error() == std::errc::no_such_file_or_directory);
+    ut::expect(ut::throws<std::system_error>([&] { [[maybe_unused]] auto r = missing.as_body_reader(); }));
+  };
+#endif
+
+  "percent encoding"_test = [] {
+    using namespace std::string_view_literals;
+
+    auto encode = [](std::string_view str, bool space_as_plus = false) {
+      std::string result = "prefix:";
+      chttpp::detail::append_percent_encoded(result, str, space_as_plus);
+      return result.substr(7);
+    };
+
+    ut::expect(encode("") == "");
+    ut::expect(encode("AZaz09-._~") == "AZaz09-._~");
+    ut::expect(encode("a b&c=d/e?f#g%h+") == "a%20b%26c%3Dd%2Fe%3Ff%23g%25h%2B");
+    ut::expect(encode("a b", true) == "a+b");
+    ut::expect(encode("\x00\x7F\x80\xFF"sv) == "%00%7F%80%FF");
+    ut::expect(encode("日本") == "%E6%97%A5%E6%9C%AC");
+
+    // 8バイト単位の判定の境界付近
+    constexpr auto long_str = "abcdefgh ijklmnopqrstuvw/xyz0123456789-~"sv;
+    ut::expect(encode(long_str) == "abcdefgh%20ijklmnopqrstuvw%2Fxyz0123456789-~");
+    ut::expect(chttpp::detail::percent_encoded_size(long_str) == encode(long_str).size());
+    ut::expect(chttpp::detail::percent_encoded_size(long_str, true) == encode(long_str, true).size());
+
+    for (std::size_t i = 0; i < long_str.size(); ++i) {
+      ut::expect(chttpp::detail::find_reserved(long_str, i) == (i <= 8 ? 8u : i <= 24 ? 24u : long_str.size()));
+    }
+
+    // 定数式でも使用できる
+    static_assert(chttpp::detail::percent_encoded_size("a b", true) == 3);
+  };
+
+  "form_body"_test = [] {
+    using namespace std::string_view_literals;
+
+    static_assert(chttpp::byte_serializable<chttpp::form_body>);
+    static_assert(chttpp::query_content_type<chttpp::form_body> == "application/x-www-form-urlencoded");
+
+    chttpp::form_body body{{"name", "John Doe"}, {"q", "a&b=c"}, {"empty", ""}};
+    ut::expect(body.str() == "name=John+Doe&q=a%26b%3Dc&empty=");
+
+    auto bytes = chttpp::cpo::as_byte_seq(body);
+    ut::expect(std::string_view{bytes.data(), bytes.size()} == body.str());
+
+    // 名前と値の組の範囲から
+    std::vector<std::pair<std::string, std::string>> fields{{"k 1", "v/1"}, {"k2", "v2"}};
+    ut::expect(chttpp::form_body{fields}.str() == "k+1=v%2F1&k2=v2");
+
+    // コンパイル時に指定したフィールド名
+    std::string password = "p@ss word";
+    auto login = chttpp::form_body::of<"user", "pass word">("alice"sv, password);
+    ut::expect(login.str() == "user=alice&pass+word=p%40ss+word");
+
+    ut::expect(chttpp::form_body{}.str().empty());
+    ut::expect(chttpp::form_body::of<>().str().empty());
+  };
+}
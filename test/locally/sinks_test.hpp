@@ -0,0 +1,196 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <span>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+
+#include "chttpp.hpp"
+
+#define BOOST_UT_DISABLE_MODULE
+#include <boost/ut.hpp>
+
+void sinks_test() {
+  using namespace boost::ut::literals;
+  using namespace boost::ut::operators::terse;
+  namespace ut = boost::ut;
+  using namespace std::string_view_literals;
+
+  "digest algorithms"_test = [] {
+    {
+      chttpp::digest::sha256 hash{};
+      ut::expect(chttpp::digest::to_hex(hash.value()) == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+
+      hash.update("abc"sv);
+      ut::expect(chttpp::digest::to_hex(hash.value()) == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    }
+    {
+      // ブロック境界をまたいで分割して入力する
+      constexpr auto msg = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"sv;
+
+      for (std::size_t n : {1u, 7u, 55u, 56u}) {
+        chttpp::digest::sha256 hash{};
+        for (std::size_t pos = 0; pos < msg.size(); pos += n) {
+          hash.update(msg.substr(pos, n));
+        }
+        ut::expect(chttpp::digest::to_hex(hash.value()) == "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1") << n;
+      }
+    }
+    {
+      chttpp::digest::md5 hash{};
+      ut::expect(chttpp::digest::to_hex(hash.value()) == "d41d8cd98f00b204e9800998ecf8427e");
+
+      hash.update("The quick brown fox jumps over the lazy dog"sv);
+      ut::expect(chttpp::digest::to_hex(hash.value()) == "9e107d9d372bb6826bd81d3542a419d6");
+      ut::expect(chttpp::digest::to_base64(hash.value()) == "nhB9nTcrtoJr2B01QqQZ1g==");
+    }
+    {
+      chttpp::digest::crc32 crc{};
+      crc.update("123456789"sv);
+      ut::expect(crc.checksum() == 0xcbf43926u);
+
+      chttpp::digest::crc32c crcc{};
+      crcc.update("12345"sv);
+      crcc.update("6789"sv);
+      ut::expect(crcc.checksum() == 0xe3069283u);
+      ut::expect(chttpp::digest::to_hex(crcc.value()) == "e3069283");
+    }
+    {
+      using chttpp::digest::to_base64;
+
+      const unsigned char bytes[] = { 'f', 'o', 'o', 'b', 'a', 'r' };
+      ut::expect(to_base64(std::span{bytes}.first(0)) == "");
+      ut::expect(to_base64(std::span{bytes}.first(1)) == "Zg==");
+      ut::expect(to_base64(std::span{bytes}.first(2)) == "Zm8=");
+      ut::expect(to_base64(std::span{bytes}.first(3)) == "Zm9v");
+      ut::expect(to_base64(std::span{bytes}) == "Zm9vYmFy");
+    }
+  };
+
+  "digest sink verify"_test = [] {
+    using chttpp::sinks::digest_check;
+
+    chttpp::sinks::sha256_sink sha{};
+    chttpp::sinks::md5_sink md5{};
+    sha("hello"sv);
+    md5("hello"sv);
+
+    const auto sha_b64 = sha.base64();
+    ut::expect(sha_b64 == "LPJNul+wow4m6DsqxbninhsWHlwfp0JecwQzYpOLmCQ=");
+
+    {
+      // RFC 9530
+      chttpp::header_t headers{};
+      headers.emplace("content-digest", "sha-512=:AAAA:, sha-256=:" + sha_b64 + ":");
+      ut::expect(sha.verify(headers) == digest_check::matched);
+      ut::expect(md5.verify(headers) == digest_check::absent);
+    }
+    {
+      // RFC 3230、アルゴリズム名の大文字小文字は区別しない
+      chttpp::header_t headers{};
+      headers.emplace("digest", "SHA-256=" + sha_b64 + ",MD5=" + md5.base64());
+      ut::expect(sha.verify(headers) == digest_check::matched);
+      ut::expect(md5.verify(headers) == digest_check::matched);
+    }
+    {
+      chttpp::header_t headers{};
+      headers.emplace("content-md5", "XUFAKrxLKna5cZ2REBfFkg==");
+      headers.emplace("repr-digest", "sha-256=:X48E9qOokqqrvdts8nOJRJN3OWDUoyWxBf7kbu9DBPE=:");
+      ut::expect(md5.verify(headers) == digest_check::matched);
+      ut::expect(sha.verify(headers) == digest_check::mismatched);
+    }
+    {
+      chttpp::sinks::crc32_sink crc{};
+      chttpp::header_t headers{};
+      ut::expect(crc.verify(headers) == digest_check::absent);
+    }
+  };
+
+  "tee sink"_test = [] {
+    using chttpp::receive_status;
+
+    chttpp::sinks::sha256_sink sha{};
+    std::string copied{};
+    std::size_t calls = 0;
+
+    auto sink = chttpp::sinks::tee(sha, [&](std::span<const char> chunk) { copied.append(chunk.data(), chunk.size()); }, [&calls](std::span<const char>) { ++calls; });
+    static_assert(chttpp::detail::body_receiver<decltype(sink)>);
+
+    ut::expect(sink("ab"sv) == receive_status::proceed);
+    ut::expect(sink("c"sv) == receive_status::proceed);
+
+    // 左辺値で渡したものは参照で保持される
+    ut::expect(chttpp::digest::to_hex(sha.value()) == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    ut::expect(copied == "abc");
+    ut::expect(calls == 2u);
+  };
+
+  "tee sink pause and abort"_test = [] {
+    using chttpp::receive_status;
+
+    std::string first{}, third{};
+    int pause_count = 1;
+    bool abort_next = false;
+
+    auto sink = chttpp::sinks::tee(
+      [&](std::span<const char> chunk) { first.append(chunk.data(), chunk.size()); },
+      [&](std::span<const char>) {
+        if (abort_next) {
+          return receive_status::abort;
+        }
+        return 0 < pause_count-- ? receive_status::pause : receive_status::proceed;
+      },
+      [&](std::span<const char> chunk) { third.append(chunk.data(), chunk.size()); }
+    );
+
+    // 一時停止後に同じチャンクが渡されても、既に受け取ったreceiverには渡されない
+    ut::expect(sink("xyz"sv) == receive_status::pause);
+    ut::expect(sink("xyz"sv) == receive_status::proceed);
+    ut::expect(first == "xyz");
+    ut::expect(third == "xyz");
+
+    ut::expect(sink("1"sv) == receive_status::proceed);
+    ut::expect(first == "xyz1");
+
+    // 中断した場合、後続のreceiverには渡されない
+    abort_next = true;
+    ut::expect(sink("2"sv) == receive_status::abort);
+    ut::expect(first == "xyz12");
+    ut::expect(third == "xyz1");
+  };
+
+  "file sink"_test = [] {
+    using chttpp::receive_status;
+
+    const auto path = std::filesystem::temp_directory_path() / "chttpp_file_sink_test.bin";
+
+    {
+      chttpp::sinks::file_sink file{path};
+      chttpp::sinks::crc32_sink crc{};
+
+      auto sink = chttpp::sinks::tee(file, crc);
+      ut::expect(sink("123"sv) == receive_status::proceed);
+      ut::expect(sink("456789"sv) == receive_status::proceed);
+
+      ut::expect(bool(file));
+      ut::expect(file.bytes_written() == 9u);
+      ut::expect(crc.value() == chttpp::digest::crc32::result_type{0xcb, 0xf4, 0x39, 0x26});
+    }
+
+    std::ifstream ifs{path, std::ios::binary};
+    std::stringstream ss;
+    ss << ifs.rdbuf();
+    ut::expect(ss.str() == "123456789");
+    ifs.close();
+
+    std::filesystem::remove(path);
+
+    // 開けないファイルへの書き込みは中断する
+    chttpp::sinks::file_sink bad{std::filesystem::temp_directory_path() / "chttpp_not_exist_dir" / "file.bin"};
+    ut::expect(not bool(bad));
+    ut::expect(bad("a"sv) == receive_status::abort);
+  };
+}
@@ -0,0 +1,363 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <chrono>
+#include <array>
+#include <ranges>
+#include <algorithm>
+
+#include "chttpp.hpp"
+
+#define BOOST_UT_DISABLE_MODULE
+#include <boost/ut.hpp>
+
+void streaming_receiver_test() {
+  using namespace boost::ut::literals;
+  using namespace boost::ut::operators::terse;
+  namespace ut = boost::ut;
+
+  "record_receiver"_test = [] {
+    struct record {
+      std::uint32_t id;
+      double value;
+    };
+
+    // 送信されてくるデータ
+    std::vector<record> source;
+    for (std::uint32_t i = 0; i < 10; ++i) {
+      source.push_back({ i, i * 0.5 });
+    }
+
+    // 1バイトずらした位置にコピーし、アライメントが揃わないチャンクを作る
+    std::vector<char> wire(sizeof(record) * source.size() + 1);
+    std::memcpy(wire.data() + 1, source.data(), sizeof(record) * source.size());
+    const std::span<const char> bytes = std::span<const char>{wire}.subspan(1);
+
+    std::vector<record> received;
+    std::size_t call_count = 0;
+
+    auto receiver = chttpp::receive_records<record>([&](std::span<const record> records) {
+      ++call_count;
+      received.insert(received.end(), records.begin(), records.end());
+    });
+
+    // レコード境界と一致しない長さで区切って渡す
+    for (std::size_t pos = 0; pos < bytes.size(); pos += 7) {
+      receiver(bytes.subspan(pos, std::min<std::size_t>(7, bytes.size() - pos)));
+    }
+
+    ut::expect(received.size() == source.size()) << received.size();
+    ut::expect(receiver.pending_bytes() == 0_ull);
+    ut::expect(call_count <= source.size() * 2);
+
+    for (std::size_t i = 0; i < received.size(); ++i) {
+      ut::expect(received[i].id == source[i].id);
+      ut::expect(received[i].value == source[i].value);
+    }
+
+    // アライメントが揃っているチャンクはコピーされずにそのまま渡される
+    alignas(record) char aligned[sizeof(record) * 2 + 3]{};
+    std::memcpy(aligned, source.data(), sizeof(record) * 2);
+
+    const record* passed_ptr = nullptr;
+    auto aligned_receiver = chttpp::receive_records<record>([&](std::span<const record> records) {
+      passed_ptr = records.data();
+    });
+
+    aligned_receiver(std::span<const char>{aligned});
+
+    ut::expect(passed_ptr == reinterpret_cast<const record*>(aligned));
+    ut::expect(aligned_receiver.pending_bytes() == 3_ull);
+
+    // streaming_receiverに指定できる
+    chttpp::detail::agent_request_config cfg{ .streaming_receiver = chttpp::receive_records<record>([](std::span<const record>) {}) };
+    ut::expect(bool(cfg.streaming_receiver));
+  };
+
+  "streaming_callback"_test = [] {
+    using chttpp::receive_status;
+
+    const char data[] = "abcdef";
+    std::span<const char> chunk{data, 6};
+
+    // 空
+    chttpp::detail::streaming_callback empty{};
+    ut::expect(not bool(empty));
+
+    // 戻り値型voidのものはproceedとして扱われる
+    std::size_t count = 0;
+    chttpp::detail::streaming_callback void_cb = [&](std::span<const char> c) { count += c.size(); };
+    ut::expect(bool(void_cb));
+    ut::expect(void_cb(chunk) == receive_status::proceed);
+    ut::expect(count == 6_u);
+
+    // receive_statusを返すものはそのまま
+    int calls = 0;
+    chttpp::detail::streaming_callback status_cb = [&](std::span<const char>) {
+      return ++calls == 1 ? receive_status::pause : receive_status::abort;
+    };
+    ut::expect(status_cb(chunk) == receive_status::pause);
+    ut::expect(status_cb(chunk) == receive_status::abort);
+  };
+
+  "flow_control"_test = [] {
+    chttpp::flow_control fc;
+
+    ut::expect(not fc.consume_resume());
+
+    fc.resume();
+    ut::expect(fc.consume_resume());
+    ut::expect(not fc.consume_resume());
+
+    // 要求済みであれば待機せずに戻る
+    fc.resume();
+    fc.wait_resume();
+    ut::expect(not fc.consume_resume());
+  };
+
+  "sse_parser"_test = [] {
+    using namespace std::string_view_literals;
+    using chttpp::receive_status;
+
+    struct received_event {
+      std::string type, data, id;
+    };
+
+    constexpr auto stream = "\xEF\xBB\xBF: comment\r\n"
+                            "retry: 1500\r\n"
+                            "\r\n"
+                            "data: first\n"
+                            "\n"
+                            "id: 1\r"
+                            "event: update\r"
+                            "data:line1\r"
+                            "data: line2\r"
+                            "\r"
+                            "id\n"
+                            "data\n"
+                            "\n"
+                            "data: not terminated"sv;
+
+    const std::vector<std::tuple<std::string_view, std::string_view, std::string_view>> expected = {
+      { "message", "first", "" },
+      { "update", "line1\nline2", "1" },
+      { "message", "", "" },
+    };
+
+    // どこで分割されても同じ結果になる
+    for (const std::size_t n : std::initializer_list<std::size_t>{1, 2, 3, 7, stream.size()}) {
+      std::vector<received_event> events{};
+
+      auto parser = chttpp::parse_sse([&](const chttpp::sse_event& event) {
+        events.push_back({ std::string{event.type}, std::string{event.data}, std::string{event.id} });
+      });
+      static_assert(chttpp::detail::body_receiver<decltype(parser)>);
+
+      for (std::size_t pos = 0; pos < stream.size(); pos += n) {
+        ut::expect(parser(stream.substr(pos, n)) == receive_status::proceed);
+      }
+
+      ut::expect((events.size() == expected.size()) >> ut::fatal) << n;
+      for (std::size_t i = 0; i < expected.size(); ++i) {
+        const auto& [type, data, id] = expected[i];
+        ut::expect(events[i].type == type) << n << i;
+        ut::expect(events[i].data == data) << n << i;
+        ut::expect(events[i].id == id) << n << i;
+      }
+
+      ut::expect(parser.retry() == std::chrono::milliseconds{1500});
+      ut::expect(parser.last_event_id() == "");
+    }
+  };
+
+  "sse_parser pause and reset"_test = [] {
+    using namespace std::string_view_literals;
+    using chttpp::receive_status;
+
+    std::string received{};
+    int pause_count = 1;
+
+    auto parser = chttpp::parse_sse([&](const chttpp::sse_event& event) {
+      received.append(event.data).append("|");
+      return event.data == "b" and 0 < pause_count-- ? receive_status::pause : receive_status::proceed;
+    });
+
+    // 一時停止後に同じチャンクが渡されると、そのイベントの後から処理する
+    constexpr auto chunk = "id: 10\ndata: a\n\nid: 11\ndata: b\n\ndata: c\n\nid: 12\ndata: d"sv;
+    ut::expect(parser(chunk) == receive_status::pause);
+    ut::expect(parser(chunk) == receive_status::proceed);
+    ut::expect(received == "a|b|c|");
+    ut::expect(parser.last_event_id() == "11");
+
+    // 再接続時には受信途中のイベントを破棄する
+    parser.reset();
+    ut::expect(parser("\n"sv) == receive_status::proceed);
+    ut::expect(received == "a|b|c|");
+    ut::expect(parser.last_event_id() == "11");
+
+    ut::expect(parser("data: e\n\n"sv) == receive_status::proceed);
+    ut::expect(received == "a|b|c|e|");
+  };
+
+  "record_view"_test = [] {
+    using namespace std::string_view_literals;
+
+    static_assert(std::ranges::forward_range<chttpp::views::record_view>);
+    static_assert(std::ranges::view<chttpp::views::record_view>);
+
+    const auto to_vector = [](auto&& view) {
+      std::vector<std::string_view> result{};
+      for (auto record : view) {
+        result.push_back(record);
+      }
+      return result;
+    };
+
+    ut::expect(to_vector("a\r\nb\n\nc"sv | chttpp::views::lines) == std::vector{"a"sv, "b"sv, ""sv, "c"sv});
+    // 末尾の改行の後ろには空の行はない
+    ut::expect(to_vector("a\n"sv | chttpp::views::lines) == std::vector{"a"sv});
+    ut::expect(to_vector(""sv | chttpp::views::lines).empty());
+    ut::expect(to_vector("\n"sv | chttpp::views::lines) == std::vector{""sv});
+
+    // records()は\rを取り除かない
+    ut::expect(to_vector("1,22\r,,333"sv | chttpp::views::records(',')) == std::vector{"1"sv, "22\r"sv, ""sv, "333"sv});
+
+    // 他のRangeアダプタと組み合わせられる
+    auto sizes = chttpp::views::lines("ab\ncde\nf"sv) | std::views::transform([](std::string_view line) { return line.size(); });
+    ut::expect(std::ranges::equal(sizes, std::array{2u, 3u, 1u}));
+  };
+
+  "delimited_receiver"_test = [] {
+    using namespace std::string_view_literals;
+    using chttpp::receive_status;
+
+    constexpr auto body = "{\"a\":1}\n{\"a\":22}\r\n\n{\"a\":333}"sv;
+
+    // どこで分割されても同じ結果になる
+    for (const std::size_t n : std::initializer_list<std::size_t>{1, 3, 8, body.size()}) {
+      std::vector<std::string> lines{};
+      auto receiver = chttpp::receive_lines([&](std::string_view line) { lines.emplace_back(line); });
+      static_assert(chttpp::detail::body_receiver<decltype(receiver)>);
+
+      for (std::size_t pos = 0; pos < body.size(); pos += n) {
+        ut::expect(receiver(std::span<const char>{body.substr(pos, n)}) == receive_status::proceed);
+      }
+
+      ut::expect(lines == std::vector<std::string>{"{\"a\":1}", "{\"a\":22}", ""}) << n;
+      ut::expect(receiver.pending_bytes() == 9u) << n;
+
+      // 区切り文字で終わっていない最後のレコード
+      ut::expect(receiver.finish() == receive_status::proceed);
+      ut::expect(lines.size() == 4u);
+      ut::expect(lines.back() == "{\"a\":333}");
+      ut::expect(receiver.pending_bytes() == 0u);
+    }
+
+    // 一時停止後に同じチャンクが渡されると、そのレコードの後から処理する
+    std::string received{};
+    int pause_count = 1;
+    auto receiver = chttpp::receive_delimited('\0', [&](std::string_view record) {
+      received.append(record).append("|");
+      return record == "b" and 0 < pause_count-- ? receive_status::pause : receive_status::proceed;
+    });
+
+    constexpr auto chunk = "a\0b\0c\0"sv;
+    ut::expect(receiver(std::span<const char>{chunk}) == receive_status::pause);
+    ut::expect(receiver(std::span<const char>{chunk}) == receive_status::proceed);
+    ut::expect(received == "a|b|c|");
+  };
+  "multipart_boundary"_test = [] {
+    using namespace std::string_view_literals;
+
+    ut::expect(chttpp::multipart_boundary("multipart/byteranges; boundary=3d6b6a416f9b5") == "3d6b6a416f9b5"sv);
+    ut::expect(chttpp::multipart_boundary("multipart/mixed;charset=utf-8; Boundary=\"a b;c\"") == "a b;c"sv);
+    ut::expect(chttpp::multipart_boundary("multipart/mixed; boundary=abc; charset=utf-8") == "abc"sv);
+    ut::expect(chttpp::multipart_boundary("multipart/mixed").empty());
+    ut::expect(chttpp::multipart_boundary("text/plain; charset=utf-8").empty());
+  };
+
+  "multipart_parser"_test = [] {
+    using namespace std::string_view_literals;
+    using chttpp::receive_status;
+
+    constexpr auto body = "preamble\r\n"
+                          "--XyZ\r\n"
+                          "Content-Type: text/plain\r\n"
+                          "Content-Range: bytes 0-4/20\r\n"
+                          "\r\n"
+                          "ab\r\nc\r\n"
+                          "--XyZ  \r\n"
+                          "content-type: application/octet-stream\r\n"
+                          "\r\n"
+                          "\r\n--Xy\r\r\n--XyZ\r\n"
+                          "\r\n"
+                          "\r\n"
+                          "--XyZ--\r\n"
+                          "epilogue"sv;
+
+    // どこで分割されても同じ結果になる
+    for (const std::size_t n : std::initializer_list<std::size_t>{1, 2, 3, 5, 7, 16, body.size()}) {
+      std::vector<std::string> types{};
+      std::vector<std::string> bodies{};
+      std::optional<chttpp::detail::content_range> range{};
+
+      auto parser = chttpp::parse_multipart([&](const chttpp::multipart_part& part) {
+        ut::expect(part.index() == types.size());
+        types.emplace_back(part.content_type());
+        if (part.index() == 0) {
+          range = part.content_range();
+        }
+
+        bodies.emplace_back();
+        return [&bodies, index = part.index()](std::span<const char> data) {
+          bodies[index].append(data.data(), data.size());
+        };
+      }, "XyZ");
+      static_assert(chttpp::detail::body_receiver<decltype(parser)>);
+
+      for (std::size_t pos = 0; pos < body.size(); pos += n) {
+        ut::expect(parser(std::span<const char>{body.substr(pos, n)}) == receive_status::proceed);
+      }
+
+      ut::expect(parser.finished()) << n;
+      ut::expect(parser.part_count() == 3u) << n;
+      ut::expect(types == std::vector<std::string>{"text/plain", "application/octet-stream", ""}) << n;
+      ut::expect(bodies == std::vector<std::string>{"ab\r\nc", "\r\n--Xy\r", ""}) << n;
+      ut::expect(range.has_value() and range->first == 0u and range->last == 4u and range->length == 20u) << n;
+    }
+
+    // boundaryの自動検出、ボディを読み捨てるパート
+    std::string received{};
+    auto parser = chttpp::parse_multipart([&](const chttpp::multipart_part& part) -> chttpp::detail::streaming_callback {
+      if (part.index() == 0) {
+        return nullptr;
+      }
+      return [&](std::span<const char> data) { received.append(data.data(), data.size()); };
+    });
+
+    constexpr auto detected = "--b1\r\n\r\nskip\r\n--b1\r\nX-A: 1\r\n\r\nkeep\r\n--b1--"sv;
+    ut::expect(parser(std::span<const char>{detected}) == receive_status::proceed);
+    ut::expect(parser.finished());
+    ut::expect(received == "keep");
+
+    // 一時停止後に同じチャンクが渡されると、そのデータの位置から処理する
+    std::string paused{};
+    int pause_count = 1;
+    auto pausing = chttpp::parse_multipart([&](const chttpp::multipart_part&) {
+      return [&](std::span<const char> data) {
+        paused.append(data.data(), data.size()).append("|");
+        return 0 < pause_count-- ? receive_status::pause : receive_status::proceed;
+      };
+    }, "b");
+
+    constexpr auto chunk = "--b\r\n\r\nxyz\r\n--b--\r\n"sv;
+    ut::expect(pausing(std::span<const char>{chunk}) == receive_status::pause);
+    ut::expect(pausing(std::span<const char>{chunk}) == receive_status::proceed);
+    ut::expect(paused == "xyz|xyz|");
+    ut::expect(pausing.finished());
+  };
+}
@@ -2,4 +2,9 @@
 #include "locally/exptr_wrapper_test.hpp"
 #include "locally/http_config_test.hpp"
 #include "locally/http_result_test.hpp"
-#include "locally/status_code_test.hpp"
\ No newline at end of file
+#include "locally/status_code_test.hpp"
+#include "locally/streaming_receiver_test.hpp"
+#include "locally/request_body_test.hpp"
+#include "locally/range_request_test.hpp"
+#include "locally/sinks_test.hpp"
+#include "locally/json_view_test.hpp"
\ No newline at end of file
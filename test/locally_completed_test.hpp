@@ -4,4 +4,9 @@ void cookie_test();
 void exptr_wrapper_test();
 void http_result_test();
 void status_code_test();
-void http_config_test();
\ No newline at end of file
+void http_config_test();
+void streaming_receiver_test();
+void request_body_test();
+void range_request_test();
+void sinks_test();
+void json_view_test();
\ No newline at end of file